@@ -9,18 +9,46 @@
 #ifndef DISTRHO_PLUGIN_INFO_H_INCLUDED
 #define DISTRHO_PLUGIN_INFO_H_INCLUDED
 
-// Plugin metadata
+// Channel count of this build (2..16). The default build is stereo; CMake adds
+// surround / multi-mic variants by defining FREQUENCYGATE_NUM_CHANNELS.
+#define MAX_CHANNELS                   16  // DSP engine limit (offline tools choose at runtime)
+#ifndef FREQUENCYGATE_NUM_CHANNELS
+#define FREQUENCYGATE_NUM_CHANNELS     2
+#endif
+#if FREQUENCYGATE_NUM_CHANNELS < 2 || FREQUENCYGATE_NUM_CHANNELS > MAX_CHANNELS
+#error "FREQUENCYGATE_NUM_CHANNELS must be between 2 and 16"
+#endif
+
+#define FREQUENCYGATE_STR_(x)          #x
+#define FREQUENCYGATE_STR(x)           FREQUENCYGATE_STR_(x)
+#define FREQUENCYGATE_CAT_(a, b)       a##b
+#define FREQUENCYGATE_CAT(a, b)        FREQUENCYGATE_CAT_(a, b)
+
+// Plugin metadata (variants get their own name and IDs so they can coexist with the stereo build)
 #define DISTRHO_PLUGIN_BRAND           "StreamTools"
+#if FREQUENCYGATE_NUM_CHANNELS == 2
 #define DISTRHO_PLUGIN_NAME            "FrequencyGate"
 #define DISTRHO_PLUGIN_URI             "https://github.com/streamtools/frequencygate"
 #define DISTRHO_PLUGIN_CLAP_ID         "com.streamtools.frequencygate"
 #define DISTRHO_PLUGIN_UNIQUE_ID       FqGt  // VST2 unique ID (4-char code)
+#define FREQUENCYGATE_ID_CHAR          't'   // Last character of the VST2 unique ID
+#else
+#define DISTRHO_PLUGIN_NAME            "FrequencyGate " FREQUENCYGATE_STR(FREQUENCYGATE_NUM_CHANNELS) "ch"
+#define DISTRHO_PLUGIN_URI             "https://github.com/streamtools/frequencygate#" FREQUENCYGATE_STR(FREQUENCYGATE_NUM_CHANNELS) "ch"
+#define DISTRHO_PLUGIN_CLAP_ID         "com.streamtools.frequencygate." FREQUENCYGATE_STR(FREQUENCYGATE_NUM_CHANNELS) "ch"
+#if FREQUENCYGATE_NUM_CHANNELS < 10
+#define DISTRHO_PLUGIN_UNIQUE_ID       FREQUENCYGATE_CAT(Fq0, FREQUENCYGATE_NUM_CHANNELS)  // Fq06, Fq08, ...
+#else
+#define DISTRHO_PLUGIN_UNIQUE_ID       FREQUENCYGATE_CAT(Fq, FREQUENCYGATE_NUM_CHANNELS)   // Fq10 .. Fq16
+#endif
+#define FREQUENCYGATE_ID_CHAR          ('a' + FREQUENCYGATE_NUM_CHANNELS)
+#endif
 
 // Plugin features
 #define DISTRHO_PLUGIN_HAS_UI          1
 #define DISTRHO_PLUGIN_IS_RT_SAFE      1
-#define DISTRHO_PLUGIN_NUM_INPUTS      2
-#define DISTRHO_PLUGIN_NUM_OUTPUTS     2
+#define DISTRHO_PLUGIN_NUM_INPUTS      (FREQUENCYGATE_NUM_CHANNELS + 2)  // Main channels + stereo sidechain (key)
+#define DISTRHO_PLUGIN_NUM_OUTPUTS     FREQUENCYGATE_NUM_CHANNELS
 #define DISTRHO_PLUGIN_WANT_LATENCY    1  // Required for FFT + lookahead
 #define DISTRHO_PLUGIN_WANT_STATE      0
 #define DISTRHO_PLUGIN_WANT_TIMEPOS    0
@@ -32,10 +60,30 @@
 #define DISTRHO_UI_DEFAULT_HEIGHT      620
 #define DISTRHO_UI_USE_NANOVG          1
 
-// Default FFT settings (can be changed at runtime)
+// Default FFT settings (can be changed at runtime). The FFT Size options are analysis
+// windows in milliseconds: the sizes below at 48 kHz, rescaled at other sample rates.
 #define DEFAULT_FFT_SIZE    2048   // ~10ms latency at 48kHz with 75% overlap
-#define MAX_FFT_SIZE        4096   // Maximum supported FFT size
+#define MAX_FFT_SIZE        16384  // Largest option (85 ms) at 192 kHz
+#define FFT_REFERENCE_RATE  48000.0
 #define FFT_OVERLAP         4      // 75% overlap
+#define MAX_HOP_SIZE        (MAX_FFT_SIZE / FFT_OVERLAP)
+#define MAX_AVERAGING_MS    500    // Averaging time constant range (0 = off)
+#define MAX_PREOPEN_MS      20     // Pre-Open (lookahead) range
+
+// Auto Threshold noise floor tracking
+#define AUTO_FLOOR_WINDOW_MS  3000  // Minimum search window (longer than a spoken phrase)
+#define AUTO_FLOOR_SMOOTH_MS  100   // Level smoothing before the minimum search
+
+// Shared analysis bus
+#define MAX_SHARE_GROUPS    16     // Share group IDs 1..16 (0 = analyze locally)
+#define SHARE_STALE_MS      100    // Followers take over after this long without a new decision
+#define SHARE_HISTORY       64     // Decisions kept per group (hops a follower can replay in one block)
+
+// Hot-path instrumentation (FrequencyGateStats.hpp); 0 strips the counters entirely
+#ifndef FREQUENCYGATE_INSTRUMENTATION
+#define FREQUENCYGATE_INSTRUMENTATION 1
+#endif
+#define DSP_LOAD_SMOOTH_MS  300    // DSP Load meter smoothing
 
 // Parameter enumeration
 enum Parameters {
@@ -50,7 +98,18 @@ enum Parameters {
     kParamHysteresis,       // Hysteresis (dB) - difference between open and close thresholds
     kParamRange,            // Gate attenuation when closed (dB)
     kParamFFTSize,          // FFT size selection (0=512, 1=1024, 2=2048, 3=4096)
-    kParamCount
+    kParamGateMode,         // Gate mode (0=Broadband, 1=Spectral)
+    kParamAutoThreshold,    // Track the noise floor and open at floor + margin
+    kParamAutoMargin,       // Auto Threshold margin above the noise floor (dB)
+    kParamNoiseFloor,       // Output: tracked noise floor of the detection band (dB)
+    kParamShareGroup,       // Shared analysis group (0=Off, 1..16)
+    kParamKeySource,        // Detection key (0=Main input, 1=Sidechain input)
+    kParamDspLoad,          // Output: processing time as % of the audio it covered (smoothed)
+    kParamDspPeak,          // Output: worst single block (%) since activation
+    kParamAveraging,        // Per-bin magnitude averaging across hops (ms, 0=Off)
+    kParamChannelDetect,    // How the key channels are combined for detection (see ChannelDetect)
+    kParamChannelWeight0,   // Detection mix weight of each main channel (one parameter per channel)
+    kParamCount = kParamChannelWeight0 + FREQUENCYGATE_NUM_CHANNELS
 };
 
 // Detection method enumeration
@@ -60,9 +119,36 @@ enum DetectionMethod {
     kDetectMedian,          // Median magnitude (robust to outliers)
     kDetectRMS,             // RMS magnitude (energy-based)
     kDetectTrimmedMean,     // Trimmed mean (removes top/bottom 10%, best for noise rejection)
+    kDetectFlatness,        // Average, attenuated when the band spectrum is flat (fans, HVAC)
+    kDetectHarmonic,        // Average, attenuated when the band has no harmonic comb (unvoiced noise)
     kDetectCount
 };
 
+// Gate mode enumeration
+enum GateMode {
+    kGateBroadband = 0,     // One gain for the whole signal (default)
+    kGateSpectral,          // Per-bin gain mask with overlap-add resynthesis
+    kGateModeCount
+};
+
+// Key source enumeration
+enum KeySource {
+    kKeyMain = 0,           // Detect on the signal being gated (default)
+    kKeySidechain,          // Detect on the sidechain input pair
+    kKeySourceCount
+};
+
+// Channel detection enumeration: Mix analyzes the weighted mix of the key channels; the
+// others analyze each channel and combine the band spectra per bin, so out-of-phase or
+// hard-panned content is not cancelled or halved by the mix
+enum ChannelDetect {
+    kChannelMix = 0,        // Weighted mono mix (default)
+    kChannelMax,            // Loudest channel per bin
+    kChannelMean,           // Weighted mean of the channel magnitudes
+    kChannelLinked,         // Weighted mean of the channel powers (RMS across channels)
+    kChannelDetectCount
+};
+
 // FFT size options
 enum FFTSizeOption {
     kFFTSize512 = 0,
@@ -83,4 +169,46 @@ inline int getFFTSizeFromOption(int option) {
     }
 }
 
+// Analysis window of an FFT size option (ms)
+inline double getFFTWindowMs(int option) {
+    return getFFTSizeFromOption(option) * 1000.0 / FFT_REFERENCE_RATE;
+}
+
+// PFFFT real transforms need N = 2^a * 3^b * 5^c that is a multiple of 32
+inline bool isFFTSizeSupported(int n) {
+    if (n < 32 || n % 32 != 0) return false;
+    while (n % 2 == 0) n /= 2;
+    while (n % 3 == 0) n /= 3;
+    while (n % 5 == 0) n /= 5;
+    return n == 1;
+}
+
+// FFT size for an option at a sample rate: the supported size closest to the option's window,
+// so the window and the latency it implies stay the same at every sample rate
+inline int getFFTSizeForRate(int option, double sampleRate) {
+    const double target = getFFTWindowMs(option) * sampleRate / 1000.0;
+    int best = 32;
+    double bestDistance = target > 32.0 ? target - 32.0 : 32.0 - target;
+    for (int n = 64; n <= MAX_FFT_SIZE; n += 32) {
+        const double distance = n > target ? n - target : target - n;
+        if (distance < bestDistance && isFFTSizeSupported(n)) {
+            best = n;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+// Short channel label for parameter names and the UI (speaker names for the common layouts)
+inline const char* getChannelLabel(int channel) {
+    static const char* const kStereo[] = { "L", "R" };
+    static const char* const kSurround[] = { "L", "R", "C", "LFE", "Ls", "Rs", "Lb", "Rb" };
+    static const char* const kNumbers[] = { "1", "2", "3", "4", "5", "6", "7", "8",
+                                            "9", "10", "11", "12", "13", "14", "15", "16" };
+    if (channel < 0 || channel >= FREQUENCYGATE_NUM_CHANNELS) return "";
+    if (FREQUENCYGATE_NUM_CHANNELS == 2) return kStereo[channel];
+    if (FREQUENCYGATE_NUM_CHANNELS == 6 || FREQUENCYGATE_NUM_CHANNELS == 8) return kSurround[channel];
+    return kNumbers[channel];
+}
+
 #endif // DISTRHO_PLUGIN_INFO_H_INCLUDED
@@ -0,0 +1,195 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * WAV / raw PCM layout and sample conversion for the offline tools
+ *
+ * Works on memory-mapped bytes: parseWav() locates the sample data, readFrames()
+ * decodes any frame range into planar floats and writeFrames() encodes planar floats
+ * back into interleaved samples, so chunks can be converted independently.
+ */
+
+#ifndef FREQUENCY_GATE_AUDIO_FILE_HPP_INCLUDED
+#define FREQUENCY_GATE_AUDIO_FILE_HPP_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace AudioFile {
+
+enum SampleFormat {
+    kSampleS16 = 0,
+    kSampleS24,
+    kSampleS32,
+    kSampleF32
+};
+
+struct Layout {
+    int channels = 0;
+    double sampleRate = 0.0;
+    SampleFormat format = kSampleF32;
+    size_t dataOffset = 0;   // Byte offset of the first frame
+    uint64_t frames = 0;
+
+    int bytesPerSample() const { return format == kSampleS16 ? 2 : format == kSampleS24 ? 3 : 4; }
+    size_t bytesPerFrame() const { return static_cast<size_t>(channels) * bytesPerSample(); }
+};
+
+inline uint16_t readU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+inline void writeU16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+inline void writeU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF; }
+
+// RIFF/WAVE with PCM 16/24/32-bit or IEEE float 32-bit samples (plain or WAVE_FORMAT_EXTENSIBLE)
+inline bool parseWav(const uint8_t* data, size_t size, Layout& layout, std::string& error)
+{
+    if (!data || size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+    bool haveFormat = false;
+    int bits = 0, tag = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = data + pos;
+        const size_t chunkSize = readU32(chunk + 4);
+        const size_t body = pos + 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && body + 16 <= size) {
+            tag = readU16(data + body);
+            layout.channels = readU16(data + body + 2);
+            layout.sampleRate = readU32(data + body + 4);
+            bits = readU16(data + body + 14);
+            if (tag == 0xFFFE && chunkSize >= 40 && body + 26 <= size) tag = readU16(data + body + 24);
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) { error = "data chunk before fmt chunk"; return false; }
+            if (tag == 1 && bits == 16) layout.format = kSampleS16;
+            else if (tag == 1 && bits == 24) layout.format = kSampleS24;
+            else if (tag == 1 && bits == 32) layout.format = kSampleS32;
+            else if (tag == 3 && bits == 32) layout.format = kSampleF32;
+            else { error = "unsupported sample format (PCM 16/24/32 or float 32 only)"; return false; }
+            if (layout.channels <= 0 || layout.sampleRate <= 0.0) { error = "invalid fmt chunk"; return false; }
+            layout.dataOffset = body;
+            const size_t available = (body + chunkSize <= size) ? chunkSize : size - body;  // Tolerate truncation
+            layout.frames = available / layout.bytesPerFrame();
+            return true;
+        }
+        pos = body + chunkSize + (chunkSize & 1);
+    }
+    error = "no data chunk";
+    return false;
+}
+
+// Decode frames [start, start + count) into planar buffers; frames past the end read as silence
+inline void readFrames(const uint8_t* data, const Layout& layout, uint64_t start, uint32_t count,
+                       float* const* planar)
+{
+    const uint32_t valid = start >= layout.frames ? 0
+        : static_cast<uint32_t>(std::min<uint64_t>(count, layout.frames - start));
+    const int channels = layout.channels;
+    const uint8_t* src = data + layout.dataOffset + start * layout.bytesPerFrame();
+    for (uint32_t i = 0; i < valid; i++) {
+        for (int c = 0; c < channels; c++) {
+            float v;
+            switch (layout.format) {
+                case kSampleS16:
+                    v = static_cast<int16_t>(readU16(src)) * (1.0f / 32768.0f);
+                    src += 2;
+                    break;
+                case kSampleS24: {
+                    const int32_t s = static_cast<int32_t>((src[0] << 8) | (src[1] << 16) | (static_cast<uint32_t>(src[2]) << 24)) >> 8;
+                    v = s * (1.0f / 8388608.0f);
+                    src += 3;
+                    break;
+                }
+                case kSampleS32:
+                    v = static_cast<float>(static_cast<int32_t>(readU32(src)) * (1.0 / 2147483648.0));
+                    src += 4;
+                    break;
+                case kSampleF32:
+                default: {
+                    const uint32_t bits = readU32(src);
+                    std::memcpy(&v, &bits, sizeof(v));
+                    src += 4;
+                    break;
+                }
+            }
+            planar[c][i] = v;
+        }
+    }
+    for (int c = 0; c < channels; c++)
+        if (valid < count) std::memset(planar[c] + valid, 0, (count - valid) * sizeof(float));
+}
+
+// 32-bit float WAV header (WAVE_FORMAT_EXTENSIBLE above two channels)
+inline size_t wavHeaderSize(int channels) { return channels > 2 ? 68 : 44; }
+
+inline void writeWavHeader(uint8_t* dst, int channels, double sampleRate, uint64_t frames)
+{
+    const bool extensible = channels > 2;
+    const uint32_t fmtSize = extensible ? 40 : 16;
+    const uint32_t blockAlign = static_cast<uint32_t>(channels) * 4;
+    const uint32_t dataSize = static_cast<uint32_t>(frames * blockAlign);
+    const size_t header = wavHeaderSize(channels);
+    std::memcpy(dst, "RIFF", 4);
+    writeU32(dst + 4, static_cast<uint32_t>(header - 8 + dataSize));
+    std::memcpy(dst + 8, "WAVEfmt ", 8);
+    writeU32(dst + 16, fmtSize);
+    writeU16(dst + 20, extensible ? 0xFFFE : 3);
+    writeU16(dst + 22, static_cast<uint16_t>(channels));
+    writeU32(dst + 24, static_cast<uint32_t>(sampleRate));
+    writeU32(dst + 28, static_cast<uint32_t>(sampleRate) * blockAlign);
+    writeU16(dst + 32, static_cast<uint16_t>(blockAlign));
+    writeU16(dst + 34, 32);
+    if (extensible) {
+        static const uint8_t kFloatGuid[16] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                                0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        writeU16(dst + 36, 22);
+        writeU16(dst + 38, 32);
+        writeU32(dst + 40, 0);   // No speaker mask
+        std::memcpy(dst + 44, kFloatGuid, 16);
+    }
+    std::memcpy(dst + header - 8, "data", 4);
+    writeU32(dst + header - 4, dataSize);
+}
+
+// Encode planar floats as interleaved samples in the layout's format (integers are clipped)
+inline void writeFrames(uint8_t* data, const Layout& layout, uint64_t start, uint32_t count,
+                        const float* const* planar)
+{
+    const int channels = layout.channels;
+    uint8_t* dst = data + layout.dataOffset + start * layout.bytesPerFrame();
+    for (uint32_t i = 0; i < count; i++) {
+        for (int c = 0; c < channels; c++) {
+            const float v = planar[c][i];
+            const float clipped = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+            switch (layout.format) {
+                case kSampleS16:
+                    writeU16(dst, static_cast<uint16_t>(static_cast<int16_t>(std::lrint(clipped * 32767.0f))));
+                    dst += 2;
+                    break;
+                case kSampleS24: {
+                    const int32_t s = static_cast<int32_t>(std::lrint(clipped * 8388607.0f));
+                    dst[0] = s & 0xFF; dst[1] = (s >> 8) & 0xFF; dst[2] = (s >> 16) & 0xFF;
+                    dst += 3;
+                    break;
+                }
+                case kSampleS32:
+                    writeU32(dst, static_cast<uint32_t>(static_cast<int32_t>(std::lrint(clipped * 2147483647.0))));
+                    dst += 4;
+                    break;
+                case kSampleF32:
+                default:
+                    std::memcpy(dst, &v, sizeof(float));
+                    dst += sizeof(float);
+                    break;
+            }
+        }
+    }
+}
+
+} // namespace AudioFile
+
+#endif // FREQUENCY_GATE_AUDIO_FILE_HPP_INCLUDED
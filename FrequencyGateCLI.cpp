@@ -0,0 +1,397 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Offline batch processor
+ *
+ * Gates WAV or raw PCM files with the plugin's DSP engine, without a host or UI.
+ * Files run in parallel on a worker pool. Long files are also split: detection
+ * levels are computed per chunk in parallel (each chunk re-reads one FFT frame of
+ * warm-up before it), then one pass per file runs the gate, envelope and gain
+ * from those levels. The gate state is never split, so the output is sample-identical
+ * to processing the whole file in one go.
+ */
+
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGateAudioFile.hpp"
+#include "FrequencyGateMappedFile.hpp"
+#include "FrequencyGatePresets.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const uint32_t kBlockFrames = 4096;  // Decode / process granularity (does not affect the output)
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output;                  // File (single input) or directory
+    std::string suffix = "_gated";
+    FrequencyGatePresets::ParamList params;
+    int jobs = 0;                        // 0 = all cores
+    double chunkSeconds = 30.0;          // 0 = never split a file
+    bool raw = false;
+    AudioFile::SampleFormat rawFormat = AudioFile::kSampleF32;
+    int rawChannels = 2;
+    double rawRate = 48000.0;
+    bool compensateLatency = true;
+    bool verbose = false;
+    std::string eventLogDir;             // Gate event CSVs (empty = off)
+};
+
+struct FileJob {
+    std::string inPath;
+    std::string outPath;
+    MappedFile in;
+    MappedFile out;
+    AudioFile::Layout inLayout;
+    AudioFile::Layout outLayout;
+    uint32_t latency = 0;
+    uint64_t totalFrames = 0;            // Input frames plus the latency flush
+    int hopSize = 0;
+    int fftSize = 0;
+    bool split = false;
+    std::vector<float> levels;           // Split files: one detection level per hop
+    std::atomic<int> chunksLeft{0};
+    GateStats::Snapshot stats;           // Engine counters of the gate pass
+};
+
+// Simple FIFO worker pool: tasks may queue follow-up tasks (a file's apply pass)
+class WorkerPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkerPool(int threads) : mBusySeconds(threads, 0.0) { mThreadCount = threads; }
+
+    void push(Task task)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(task));
+        mPending++;
+        mCondition.notify_one();
+    }
+
+    // Run until every task (including follow-ups) has finished
+    void run()
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < mThreadCount; t++) threads.emplace_back([this, t] { work(t); });
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    const std::vector<double>& busySeconds() const { return mBusySeconds; }
+
+private:
+    void work(int index)
+    {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return !mTasks.empty() || mPending == 0; });
+                if (mTasks.empty()) return;
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            task();
+            mBusySeconds[index] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mPending == 0) mCondition.notify_all();
+        }
+    }
+
+    int mThreadCount;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Task> mTasks;
+    int mPending = 0;
+    std::vector<double> mBusySeconds;
+};
+
+static void printUsage()
+{
+    std::printf(
+        "Usage: frequencygate-cli [options] <input>...\n"
+        "\n"
+        "  -o, --output <path>      Output file (one input) or directory\n"
+        "      --suffix <text>      Suffix for outputs written next to the input (default _gated)\n"
+        "      --preset <file>      Parameter preset: one '<parameter> = <value>' per line\n"
+        "      --<parameter> <v>    Set a parameter, e.g. --threshold -35 --fft_size 3\n"
+        "  -j, --jobs <n>           Worker threads (default: all cores)\n"
+        "      --chunk <seconds>    Split files longer than this across workers (default 30, 0 = off)\n"
+        "      --raw <f32|s16>      Headerless interleaved PCM input (output is raw f32)\n"
+        "      --channels <n>       Raw input channels (default 2)\n"
+        "      --rate <hz>          Raw input sample rate (default 48000)\n"
+        "      --no-latency-compensation  Keep the plugin's reported latency in the output\n"
+        "      --event-log <dir>    Write gate events to <dir>/<input name>.events.csv\n"
+        "  -v, --verbose            Per-file (engine counters) and per-worker statistics\n"
+        "\n"
+        "Parameters: freq_low freq_high threshold detection preopen attack hold release\n"
+        "            hysteresis range fft_size gate_mode auto_threshold auto_margin averaging\n"
+        "            channel_detect detect_weight_1..16 (values as in the plugin; enums by index)\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt, std::string& error)
+{
+    FrequencyGatePresets::ParamList cliParams;
+    auto needValue = [&](int& i) -> const char* {
+        if (i + 1 >= argc) { error = std::string("missing value for ") + argv[i]; return nullptr; }
+        return argv[++i];
+    };
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const char* v = nullptr;
+        if (arg == "-h" || arg == "--help") { printUsage(); std::exit(0); }
+        else if (arg == "-v" || arg == "--verbose") opt.verbose = true;
+        else if (arg == "--no-latency-compensation") opt.compensateLatency = false;
+        else if (arg == "-o" || arg == "--output") { if (!(v = needValue(i))) return false; opt.output = v; }
+        else if (arg == "--event-log") { if (!(v = needValue(i))) return false; opt.eventLogDir = v; }
+        else if (arg == "--suffix") { if (!(v = needValue(i))) return false; opt.suffix = v; }
+        else if (arg == "--preset") {
+            if (!(v = needValue(i))) return false;
+            if (!FrequencyGatePresets::loadPreset(v, opt.params, error)) return false;
+        }
+        else if (arg == "-j" || arg == "--jobs") { if (!(v = needValue(i))) return false; opt.jobs = std::atoi(v); }
+        else if (arg == "--chunk") { if (!(v = needValue(i))) return false; opt.chunkSeconds = std::atof(v); }
+        else if (arg == "--channels") { if (!(v = needValue(i))) return false; opt.rawChannels = std::atoi(v); }
+        else if (arg == "--rate") { if (!(v = needValue(i))) return false; opt.rawRate = std::atof(v); }
+        else if (arg == "--raw") {
+            if (!(v = needValue(i))) return false;
+            opt.raw = true;
+            if (std::strcmp(v, "f32") == 0) opt.rawFormat = AudioFile::kSampleF32;
+            else if (std::strcmp(v, "s16") == 0) opt.rawFormat = AudioFile::kSampleS16;
+            else { error = "--raw expects f32 or s16"; return false; }
+        }
+        else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            if (!(v = needValue(i))) return false;
+            float value;
+            std::pair<uint32_t, float> param;
+            if (!FrequencyGatePresets::parseValue(v, value) || !FrequencyGatePresets::resolve(arg.substr(2), value, param)) {
+                error = "unknown option or bad value: " + arg + " " + v;
+                return false;
+            }
+            cliParams.push_back(param);
+        }
+        else if (arg.size() > 1 && arg[0] == '-') { error = "unknown option: " + arg; return false; }
+        else opt.inputs.push_back(arg);
+    }
+    // Command-line values override the preset regardless of order
+    opt.params.insert(opt.params.end(), cliParams.begin(), cliParams.end());
+    if (opt.inputs.empty()) { error = "no input files"; return false; }
+    if (opt.raw && (opt.rawChannels < 1 || opt.rawChannels > MAX_CHANNELS || opt.rawRate <= 0.0)) {
+        error = "raw input needs 1-16 channels and a positive sample rate";
+        return false;
+    }
+    return true;
+}
+
+static std::string outputPathFor(const Options& opt, const std::string& input)
+{
+    const fs::path in(input);
+    const std::string name = in.stem().string() + opt.suffix + in.extension().string();
+    if (opt.output.empty()) return (in.parent_path() / name).string();
+    if (fs::is_directory(opt.output)) return (fs::path(opt.output) / name).string();
+    return opt.output;
+}
+
+static void configure(FrequencyGateDSP& dsp, const Options& opt, double sampleRate)
+{
+    dsp.setSampleRate(sampleRate);
+    for (const auto& param : opt.params) dsp.setParameter(param.first, param.second);
+    dsp.activate();
+}
+
+// Planar scratch for one block of every channel
+struct BlockBuffers {
+    explicit BlockBuffers(int channels)
+        : storage(static_cast<size_t>(2 * channels) * kBlockFrames), in(channels + 2, nullptr), out(channels)
+    {
+        for (int c = 0; c < channels; c++) {
+            in[c] = &storage[static_cast<size_t>(c) * kBlockFrames];
+            out[c] = &storage[static_cast<size_t>(channels + c) * kBlockFrames];
+        }
+    }
+    std::vector<float> storage;
+    std::vector<float*> in;   // Main channels, then the (unconnected) sidechain pair
+    std::vector<float*> out;
+};
+
+static bool openJob(FileJob& job, const Options& opt, std::string& error)
+{
+    if (!job.in.openRead(job.inPath)) { error = "cannot open " + job.inPath; return false; }
+
+    if (opt.raw) {
+        job.inLayout.channels = opt.rawChannels;
+        job.inLayout.sampleRate = opt.rawRate;
+        job.inLayout.format = opt.rawFormat;
+        job.inLayout.dataOffset = 0;
+        job.inLayout.frames = job.in.size() / job.inLayout.bytesPerFrame();
+    } else if (!AudioFile::parseWav(job.in.data(), job.in.size(), job.inLayout, error)) {
+        error = job.inPath + ": " + error;
+        return false;
+    }
+    if (job.inLayout.channels > MAX_CHANNELS) { error = job.inPath + ": more than 16 channels"; return false; }
+
+    // Probe the engine for the analysis geometry and latency of these settings
+    FrequencyGateDSP probe(job.inLayout.channels);
+    configure(probe, opt, job.inLayout.sampleRate);
+    job.latency = opt.compensateLatency ? probe.getLatency() : 0;
+    job.hopSize = probe.getHopSize();
+    job.fftSize = probe.getFFTSize();
+    job.totalFrames = job.inLayout.frames + job.latency;
+
+    const uint64_t chunkFrames = static_cast<uint64_t>(opt.chunkSeconds * job.inLayout.sampleRate);
+    job.split = probe.canSplitAnalysis() && chunkFrames > 0 && job.totalFrames > chunkFrames;
+    if (job.split) job.levels.assign(job.totalFrames / job.hopSize, -96.0f);
+
+    job.outLayout.channels = job.inLayout.channels;
+    job.outLayout.sampleRate = job.inLayout.sampleRate;
+    job.outLayout.format = AudioFile::kSampleF32;
+    job.outLayout.dataOffset = opt.raw ? 0 : AudioFile::wavHeaderSize(job.inLayout.channels);
+    job.outLayout.frames = job.inLayout.frames;
+    const size_t outSize = job.outLayout.dataOffset + job.outLayout.frames * job.outLayout.bytesPerFrame();
+    if (!job.out.create(job.outPath, outSize)) { error = "cannot create " + job.outPath; return false; }
+    if (!opt.raw) AudioFile::writeWavHeader(job.out.data(), job.outLayout.channels, job.outLayout.sampleRate, job.outLayout.frames);
+    return true;
+}
+
+// Analysis pass for input frames [start, end) (start is hop-aligned)
+static void analyzeChunk(FileJob& job, const Options& opt, uint64_t start, uint64_t end)
+{
+    FrequencyGateDSP dsp(job.inLayout.channels);
+    configure(dsp, opt, job.inLayout.sampleRate);
+    BlockBuffers buf(job.inLayout.channels);
+
+    // Warm-up: one FFT frame before the chunk refills the analysis buffer exactly
+    const uint64_t warmup = std::min<uint64_t>(start, static_cast<uint64_t>(job.fftSize));
+    uint64_t hop = start / job.hopSize;
+    for (uint64_t pos = start - warmup; pos < end; ) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kBlockFrames, (pos < start ? start : end) - pos));
+        AudioFile::readFrames(job.in.data(), job.inLayout, pos, count, buf.in.data());
+        float* levels = (pos < start) ? nullptr : &job.levels[hop];
+        const uint32_t hops = dsp.analyze(const_cast<const float**>(buf.in.data()), count, levels);
+        if (levels) hop += hops;
+        pos += count;
+    }
+}
+
+// Gate pass over the whole file: from the precomputed levels (split) or with live analysis
+static void applyFile(FileJob& job, const Options& opt)
+{
+    FrequencyGateDSP dsp(job.inLayout.channels);
+
+    // Event timestamps are input frames, so they line up with the source file
+    GateEventRecorder events;
+    if (!opt.eventLogDir.empty()) {
+        const std::string path = (fs::path(opt.eventLogDir) / (fs::path(job.inPath).stem().string() + ".events.csv")).string();
+        if (events.open(path, false)) dsp.setEventRing(&events.ring());
+        else std::fprintf(stderr, "cannot write event log %s\n", path.c_str());
+    }
+    configure(dsp, opt, job.inLayout.sampleRate);
+    BlockBuffers buf(job.inLayout.channels);
+
+    uint64_t hop = 0;
+    for (uint64_t pos = 0; pos < job.totalFrames; ) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(kBlockFrames, job.totalFrames - pos));
+        AudioFile::readFrames(job.in.data(), job.inLayout, pos, count, buf.in.data());
+        const float** in = const_cast<const float**>(buf.in.data());
+        if (job.split) hop += dsp.processWithLevels(in, buf.out.data(), count, &job.levels[hop]);
+        else dsp.process(in, buf.out.data(), count);
+        if (events.isOpen()) events.drain();
+
+        // Drop the first `latency` frames so the output lines up with the input
+        const uint64_t skip = pos < job.latency ? std::min<uint64_t>(count, job.latency - pos) : 0;
+        const uint64_t outStart = pos + skip - job.latency;
+        if (outStart < job.outLayout.frames && skip < count) {
+            const uint32_t outCount = static_cast<uint32_t>(std::min<uint64_t>(count - skip, job.outLayout.frames - outStart));
+            std::vector<const float*> planar(job.outLayout.channels);
+            for (int c = 0; c < job.outLayout.channels; c++) planar[c] = buf.out[c] + skip;
+            AudioFile::writeFrames(job.out.data(), job.outLayout, outStart, outCount, planar.data());
+        }
+        pos += count;
+    }
+    job.stats = dsp.getStats().snapshot();
+    job.out.close();
+    job.in.close();
+}
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    std::string error;
+    if (!parseArgs(argc, argv, opt, error)) {
+        std::fprintf(stderr, "frequencygate-cli: %s\n\n", error.c_str());
+        printUsage();
+        return 1;
+    }
+    const int threads = opt.jobs > 0 ? opt.jobs : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    for (const std::string& input : opt.inputs) {
+        std::unique_ptr<FileJob> job(new FileJob());
+        job->inPath = input;
+        job->outPath = outputPathFor(opt, input);
+        if (!openJob(*job, opt, error)) {
+            std::fprintf(stderr, "frequencygate-cli: %s\n", error.c_str());
+            return 1;
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    WorkerPool pool(threads);
+    double audioSeconds = 0.0;
+    for (auto& jobPtr : jobs) {
+        FileJob* job = jobPtr.get();
+        audioSeconds += job->inLayout.frames / job->inLayout.sampleRate;
+        if (!job->split) {
+            pool.push([job, &opt] { applyFile(*job, opt); });
+            continue;
+        }
+        // Hop-aligned chunks; the last one to finish queues the file's gate pass
+        const uint64_t chunkFrames = std::max<uint64_t>(job->hopSize,
+            static_cast<uint64_t>(opt.chunkSeconds * job->inLayout.sampleRate) / job->hopSize * job->hopSize);
+        const int chunks = static_cast<int>((job->totalFrames + chunkFrames - 1) / chunkFrames);
+        job->chunksLeft = chunks;
+        for (int k = 0; k < chunks; k++) {
+            const uint64_t begin = k * chunkFrames;
+            const uint64_t end = std::min(job->totalFrames, begin + chunkFrames);
+            pool.push([job, &opt, &pool, begin, end] {
+                analyzeChunk(*job, opt, begin, end);
+                if (--job->chunksLeft == 0) pool.push([job, &opt] { applyFile(*job, opt); });
+            });
+        }
+    }
+    pool.run();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double busy = 0.0;
+    for (double seconds : pool.busySeconds()) busy += seconds;
+    if (opt.verbose) {
+        std::printf("instruction set: %s\n", FrequencyGateSimd::levelName(FrequencyGateSimd::select()));
+        for (const auto& job : jobs) {
+            std::printf("%s -> %s (%s, %.1f s)\n", job->inPath.c_str(), job->outPath.c_str(),
+                        job->split ? "split" : "whole", job->inLayout.frames / job->inLayout.sampleRate);
+            printGateStats(stdout, "  gate pass", job->stats, job->inLayout.sampleRate);
+        }
+        for (size_t t = 0; t < pool.busySeconds().size(); t++)
+            std::printf("worker %zu: busy %.2f s\n", t, pool.busySeconds()[t]);
+    }
+    std::printf("%zu file(s), %.1f s of audio in %.2f s on %d worker(s): realtime x%.1f, x%.1f per core\n",
+                jobs.size(), audioSeconds, wall, threads,
+                wall > 0.0 ? audioSeconds / wall : 0.0, busy > 0.0 ? audioSeconds / busy : 0.0);
+    return 0;
+}
@@ -0,0 +1,358 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Session capture and replay
+ *
+ * A debug capture records what the host fed one instance: every input block (with its
+ * size), the output and gate decision it produced, parameter changes and activations
+ * (sample rate, hop phase). The audio thread copies each block into a preallocated
+ * single-producer / single-consumer ring; a background thread drains the ring into a
+ * memory-mapped file that grows as needed. A full ring drops the block and the capture
+ * records how many frames are missing; the audio thread never blocks, allocates or does I/O.
+ *
+ * Parameters are compared at block start on the audio thread, as the event log does, so
+ * each change lands before the block it took effect in. replayCapture() feeds a capture
+ * back through a new engine offline, as fast as it goes, and reports where the output and
+ * the gate decisions differ from what was captured.
+ *
+ * File: "FGCAPT01", channels, inputs (uint32), instruction set name (char[16]), then records
+ * of a 16-byte header and a float payload, all little-endian as written.
+ */
+
+#ifndef FREQUENCY_GATE_CAPTURE_HPP_INCLUDED
+#define FREQUENCY_GATE_CAPTURE_HPP_INCLUDED
+
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGateEventLog.hpp"
+#include "FrequencyGateMappedFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum CaptureRecordType : uint32_t {
+    kCaptureStart = 0,      // Activation: value = sample rate, index = hop phase * 2^24; parameters follow
+    kCaptureParameter,      // index = parameter, value = new value
+    kCaptureInput,          // frames, index = bit mask of the inputs present; payload: those inputs, planar
+    kCaptureOutput,         // frames, index = 1 if the gate is open after the block; payload: every channel
+    kCaptureGap,            // frames = input frames dropped (ring full) since the last record
+    kCaptureRecordTypeCount
+};
+
+struct CaptureRecord {
+    uint32_t type;
+    uint32_t frames;
+    uint32_t index;
+    float value;
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t channels;
+    uint32_t inputs;        // Main channels + key channels
+    char simd[16];          // Instruction set the captured engine ran
+};
+
+// Owns the ring and the thread that drains it to the capture file. Offline callers that
+// outrun any drain interval open without the thread and drain() after each block.
+class GateCaptureRecorder
+{
+public:
+    static constexpr size_t kRingWords = size_t(1) << 21;        // 8 MB: seconds of stereo audio
+    static constexpr size_t kFileGrowth = size_t(64) << 20;
+    static constexpr int kDrainIntervalMs = 20;
+
+    GateCaptureRecorder() : mRing(kRingWords) {}
+    ~GateCaptureRecorder() { close(); }
+
+    bool open(const std::string& path, int channels, int inputs, const char* simd, bool background = true)
+    {
+        close();
+        if (!mFile.create(path, kFileGrowth)) return false;
+        CaptureFileHeader header = {};
+        std::memcpy(header.magic, "FGCAPT01", 8);
+        header.channels = static_cast<uint32_t>(channels);
+        header.inputs = static_cast<uint32_t>(std::min(inputs, 32));
+        std::strncpy(header.simd, simd, sizeof(header.simd) - 1);
+        std::memcpy(mFile.data(), &header, sizeof(header));
+        mWritten = sizeof(header);
+        mChannels = header.channels;
+        mInputs = header.inputs;
+        mStartPending = false;
+        mDropOutput = true;
+        mLostFrames = 0;
+        for (float& value : mCapturedParams) value = std::nanf("");
+        mStop = false;
+        if (background) mThread = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Stops the drain thread after writing everything pushed before the call
+    void close()
+    {
+        if (mThread.joinable()) {
+            mStop = true;
+            mThread.join();
+        } else if (mFile.data()) {
+            drain();
+        }
+        if (mFile.data()) mFile.resize(mWritten);
+        mFile.close();
+    }
+
+    bool isOpen() const { return mFile.data() != nullptr; }
+
+    // Activation (not concurrent with the audio thread): the next block starts a new run
+    void start(double sampleRate, float hopPhase)
+    {
+        mSampleRate = static_cast<float>(sampleRate);
+        mHopPhase = static_cast<uint32_t>(std::lround(hopPhase * 16777216.0));
+        mStartPending = true;
+    }
+
+    // Audio thread, before process(): activation, parameter changes and the input block
+    void captureInput(const FrequencyGateDSP& dsp, const float* const* inputs, uint32_t frames)
+    {
+        mDropOutput = true;
+        if (mStartPending) {
+            if (!push({ kCaptureStart, 0, mHopPhase, mSampleRate })) return lose(frames);
+            mStartPending = false;
+            for (float& value : mCapturedParams) value = std::nanf("");
+        }
+        // An unrecorded change is retried at the next block; the block goes only after it
+        const uint32_t count = static_cast<uint32_t>(kParamChannelWeight0 + std::min<uint32_t>(mChannels, MAX_CHANNELS));
+        for (uint32_t index = 0; index < count; index++) {
+            if (index == kParamNoiseFloor || index == kParamDspLoad || index == kParamDspPeak) continue;
+            const float value = dsp.getParameter(index);
+            if (value == mCapturedParams[index]) continue;
+            if (!push({ kCaptureParameter, 0, index, value })) return lose(frames);
+            mCapturedParams[index] = value;
+        }
+        if (mLostFrames) {
+            if (!push({ kCaptureGap, static_cast<uint32_t>(std::min<uint64_t>(mLostFrames, UINT32_MAX)), 0, 0.0f }))
+                return lose(frames);
+            mLostFrames = 0;
+        }
+
+        uint32_t mask = 0, present = 0;
+        for (uint32_t i = 0; i < mInputs; i++) {
+            if (inputs[i]) {
+                mask |= 1u << i;
+                present++;
+            }
+        }
+        if (mRing.space() < kRecordWords + static_cast<size_t>(present) * frames) return lose(frames);
+        push({ kCaptureInput, frames, mask, 0.0f });
+        for (uint32_t i = 0; i < mInputs; i++)
+            if (inputs[i]) mRing.pushAll(reinterpret_cast<const uint32_t*>(inputs[i]), frames);
+        mDropOutput = false;
+    }
+
+    // Audio thread, after process(): the block's output and gate decision
+    void captureOutput(const FrequencyGateDSP& dsp, const float* const* outputs, uint32_t frames)
+    {
+        if (mDropOutput || mRing.space() < kRecordWords + static_cast<size_t>(mChannels) * frames) return;
+        push({ kCaptureOutput, frames, dsp.isGateOpen() ? 1u : 0u, 0.0f });
+        for (uint32_t c = 0; c < mChannels; c++) mRing.pushAll(reinterpret_cast<const uint32_t*>(outputs[c]), frames);
+    }
+
+    // Write out everything queued so far (the drain thread's job when there is one)
+    void drain()
+    {
+        for (;;) {
+            if (mFile.size() - mWritten < kFileGrowth / 4 && !mFile.resize(mFile.size() + kFileGrowth)) return;
+            const size_t room = (mFile.size() - mWritten) / sizeof(uint32_t);
+            const size_t words = mRing.popSome(reinterpret_cast<uint32_t*>(mFile.data() + mWritten), room);
+            if (words == 0) return;
+            mWritten += words * sizeof(uint32_t);
+        }
+    }
+
+private:
+    static constexpr size_t kRecordWords = sizeof(CaptureRecord) / sizeof(uint32_t);
+
+    bool push(const CaptureRecord& record)
+    {
+        return mRing.pushAll(reinterpret_cast<const uint32_t*>(&record), kRecordWords);
+    }
+
+    void lose(uint32_t frames) { mLostFrames += frames; }
+
+    void run()
+    {
+        for (;;) {
+            const bool stopping = mStop.load();
+            drain();
+            if (stopping || !mFile.data()) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(kDrainIntervalMs));
+        }
+    }
+
+    SpscRing<uint32_t> mRing;
+    MappedFile mFile;
+    size_t mWritten = 0;
+    uint32_t mChannels = 0;
+    uint32_t mInputs = 0;
+    float mSampleRate = 0.0f;
+    uint32_t mHopPhase = 0;
+    bool mStartPending = false;
+    bool mDropOutput = true;        // The input of this block was not captured
+    uint64_t mLostFrames = 0;
+    float mCapturedParams[kParamChannelWeight0 + MAX_CHANNELS];
+    std::atomic<bool> mStop{false};
+    std::thread mThread;
+
+    GateCaptureRecorder(const GateCaptureRecorder&) = delete;
+    GateCaptureRecorder& operator=(const GateCaptureRecorder&) = delete;
+};
+
+// Walks the records of a capture file (read-only mapping); stops at a truncated record
+class GateCaptureReader
+{
+public:
+    bool open(const std::string& path)
+    {
+        if (!mFile.openRead(path) || mFile.size() < sizeof(CaptureFileHeader)) return false;
+        std::memcpy(&mHeader, mFile.data(), sizeof(mHeader));
+        mHeader.simd[sizeof(mHeader.simd) - 1] = '\0';
+        mPos = sizeof(mHeader);
+        return std::memcmp(mHeader.magic, "FGCAPT01", 8) == 0 && mHeader.channels >= 1
+            && mHeader.channels <= MAX_CHANNELS && mHeader.inputs >= mHeader.channels && mHeader.inputs <= 32;
+    }
+
+    int channels() const { return static_cast<int>(mHeader.channels); }
+    int inputs() const { return static_cast<int>(mHeader.inputs); }
+    const char* simdName() const { return mHeader.simd; }
+
+    // Next record and its payload (planar floats, or null); false at the end
+    bool next(CaptureRecord& record, const float*& payload)
+    {
+        if (mFile.size() - mPos < sizeof(CaptureRecord)) return false;
+        std::memcpy(&record, mFile.data() + mPos, sizeof(record));
+        uint64_t samples = 0;
+        if (record.type == kCaptureInput) {
+            for (uint32_t i = 0; i < mHeader.inputs; i++) samples += (record.index >> i) & 1u;
+            samples *= record.frames;
+        } else if (record.type == kCaptureOutput) {
+            samples = static_cast<uint64_t>(mHeader.channels) * record.frames;
+        } else if (record.type >= kCaptureRecordTypeCount) {
+            return false;
+        }
+        const uint64_t bytes = sizeof(record) + samples * sizeof(float);
+        if (mFile.size() - mPos < bytes) return false;
+        payload = samples ? reinterpret_cast<const float*>(mFile.data() + mPos + sizeof(record)) : nullptr;
+        mPos += static_cast<size_t>(bytes);
+        return true;
+    }
+
+private:
+    MappedFile mFile;
+    CaptureFileHeader mHeader = {};
+    size_t mPos = 0;
+};
+
+struct ReplayResult {
+    uint64_t blocks = 0;
+    uint64_t frames = 0;            // Input frames replayed
+    uint32_t minBlock = 0;          // Smallest and largest host block
+    uint32_t maxBlock = 0;
+    uint64_t lostFrames = 0;        // Dropped while capturing: replay diverges after the first gap
+    uint64_t activations = 0;
+    uint64_t parameterChanges = 0;
+    double audioSeconds = 0.0;
+    double processSeconds = 0.0;    // Time in process(), all blocks
+    double worstBlockUs = 0.0;
+    uint64_t comparedBlocks = 0;    // Blocks with a captured output
+    uint64_t outputDiffBlocks = 0;  // Blocks with a sample off by more than the tolerance
+    uint64_t decisionDiffs = 0;     // Blocks after which the gate state differs
+    double maxOutputDiff = 0.0;     // Largest sample difference (linear)
+    double firstOutputDiffSeconds = -1.0;
+    double firstDecisionDiffSeconds = -1.0;
+};
+
+// Feed a capture through a new engine on `simd`; output differences up to `tolerance` count as equal
+inline ReplayResult replayCapture(GateCaptureReader& reader, FrequencyGateSimd::Level simd, double tolerance)
+{
+    ReplayResult result;
+    const int channels = reader.channels();
+    FrequencyGateDSP dsp(channels, simd);
+    std::vector<const float*> in(std::max(reader.inputs(), channels + 2), nullptr);
+    std::vector<float*> out(channels);
+    std::vector<float> output;
+    uint32_t lastFrames = 0;
+    bool activatePending = true, active = false;
+    double clock = 0.0;   // Seconds of input since the capture began
+
+    CaptureRecord record;
+    const float* payload = nullptr;
+    while (reader.next(record, payload)) {
+        switch (record.type) {
+            case kCaptureStart:
+                if (active) dsp.deactivate();
+                dsp.setSampleRate(record.value);
+                dsp.setHopPhase(static_cast<float>(record.index / 16777216.0));
+                activatePending = true;
+                active = false;
+                result.activations++;
+                break;
+            case kCaptureParameter:
+                dsp.setParameter(record.index, record.value);
+                result.parameterChanges++;
+                break;
+            case kCaptureGap:
+                result.lostFrames += record.frames;
+                break;
+            case kCaptureInput: {
+                if (activatePending) {
+                    dsp.activate();
+                    activatePending = false;
+                    active = true;
+                }
+                if (output.size() < static_cast<size_t>(channels) * record.frames)
+                    output.resize(static_cast<size_t>(channels) * record.frames);
+                for (int i = 0; i < static_cast<int>(in.size()); i++) {
+                    const bool present = i < reader.inputs() && ((record.index >> i) & 1u);
+                    in[i] = present ? payload : nullptr;
+                    if (present) payload += record.frames;
+                }
+                for (int c = 0; c < channels; c++) out[c] = &output[static_cast<size_t>(c) * record.frames];
+                const auto start = std::chrono::steady_clock::now();
+                dsp.process(in.data(), out.data(), record.frames);
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                result.processSeconds += seconds;
+                result.worstBlockUs = std::max(result.worstBlockUs, seconds * 1e6);
+                result.minBlock = result.blocks ? std::min(result.minBlock, record.frames) : record.frames;
+                result.maxBlock = std::max(result.maxBlock, record.frames);
+                result.blocks++;
+                result.frames += record.frames;
+                clock += record.frames / dsp.getSampleRate();
+                lastFrames = record.frames;
+                break;
+            }
+            case kCaptureOutput: {
+                if (record.frames != lastFrames) break;
+                double worst = 0.0;
+                for (int c = 0; c < channels; c++)
+                    for (uint32_t i = 0; i < record.frames; i++)
+                        worst = std::max(worst, std::fabs(static_cast<double>(out[c][i]) - payload[c * record.frames + i]));
+                result.comparedBlocks++;
+                result.maxOutputDiff = std::max(result.maxOutputDiff, worst);
+                if (worst > tolerance) {
+                    if (!result.outputDiffBlocks++) result.firstOutputDiffSeconds = clock;
+                }
+                if ((record.index != 0) != dsp.isGateOpen()) {
+                    if (!result.decisionDiffs++) result.firstDecisionDiffSeconds = clock;
+                }
+                break;
+            }
+        }
+    }
+    result.audioSeconds = clock;
+    return result;
+}
+
+#endif // FREQUENCY_GATE_CAPTURE_HPP_INCLUDED
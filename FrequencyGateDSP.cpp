@@ -0,0 +1,1291 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * DSP engine - Fixed FFT normalization and level detection
+ */
+
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGateKernels.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Voice feature mapping: feature value at which the band counts as noise / as voiced
+static const float kFlatnessNoise = 0.80f;     // Hann-windowed white noise measures ~0.85
+static const float kFlatnessVoiced = 0.50f;
+static const float kHarmonicityNoise = 1.8f;   // Best comb mean / band mean
+static const float kHarmonicityVoiced = 3.0f;
+static const float kVoicingFloor = 0.0631f;    // Unvoiced bands are attenuated by up to 24 dB
+static const float kPitchMinHz = 70.0f;        // Comb search range (fundamental)
+static const float kPitchMaxHz = 400.0f;
+static const float kFeatureMaxBinWidth = 50.0f; // Coarser bins cannot resolve voice harmonics
+
+// Sidechain key: both channels weigh alike in the mix and in per-channel detection
+static const float kSidechainWeights[2] = { 1.0f, 1.0f };
+
+// Closed-form envelope: curves restart from the current level every kEnvelopeTableSize samples
+// (the power table length), and snap to their target at the first sample closer than
+// kEnvelopeSettled (below float resolution at unity). Both are counted from the curve start.
+static const int kEnvelopeTableSize = 1024;
+static const float kEnvelopeSettled = 1e-7f;
+
+// Memory helpers
+void* FrequencyGateDSP::alignedAlloc(size_t size) {
+#ifdef _MSC_VER
+    return _aligned_malloc(size, 64);
+#elif defined(__MINGW32__) || defined(__MINGW64__)
+    return __mingw_aligned_malloc(size, 64);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, 64, size) != 0) return nullptr;
+    return ptr;
+#endif
+}
+
+void FrequencyGateDSP::alignedFree(void* ptr) {
+    if (!ptr) return;
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#elif defined(__MINGW32__) || defined(__MINGW64__)
+    __mingw_aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Constructor
+FrequencyGateDSP::FrequencyGateDSP(int numChannels, FrequencyGateSimd::Level simd)
+    : fFreqLow(100.0f), fFreqHigh(500.0f), fThreshold(-30.0f)
+    , fDetectionMethod(0.0f), fPreOpen(0.0f), fAttack(5.0f)
+    , fHold(50.0f), fRelease(100.0f), fHysteresis(3.0f)
+    , fRange(-96.0f), fFFTSizeOption(2.0f), fGateMode(0.0f)
+    , fAutoThreshold(0.0f), fAutoMargin(10.0f), fNoiseFloor(-96.0f), fShareGroup(0.0f)
+    , fKeySource(0.0f), fAveraging(0.0f), fChannelDetect(0.0f)
+    , mNumChannels(std::max(1, std::min(MAX_CHANNELS, numChannels)))
+    , mSampleRate(48000.0), mCurrentFFTSize(DEFAULT_FFT_SIZE)
+    , mHopSize(DEFAULT_FFT_SIZE / FFT_OVERLAP), mNeedsReinit(false)
+    , mNeedsBandUpdate(false), mNeedsLookaheadResize(false), mBufferCapacity(0)
+#ifdef USE_PFFFT
+    , mPffftSetup(nullptr), mPairSetup(nullptr)
+#endif
+    , mFftInput(nullptr), mFftOutput(nullptr), mWorkBuffer(nullptr)
+    , mSpectra(nullptr)
+    , mWindowGain(1.0f), mOlaGain(1.0f), mKeySilentSamples(0)
+    , mLookaheadWritePos(0), mLookaheadSamples(0)
+    , mInputWritePos(0), mOutputReadPos(0), mHopCounter(0), mHopPhase(0.0f)
+    , mEnvelopeLevel(0.0f), mGateGain(0.0f), mGateOpen(false)
+    , mHoldCounter(0)
+    , mAttackPowersCoeff(-1.0f), mReleasePowersCoeff(-1.0f)
+    , mEnvelopeAnchor(0.0f), mEnvelopeTarget(0.0f), mEnvelopeCoeff(0.0f), mEnvelopeSteps(0)
+    , mEnvelopeSettle(0)
+    , mFloorWarmupHops(0)
+    , mShareGroup(0), mShareRole(kShareNone), mShareSeq(0), mShareSeenSeq(0)
+    , mShareStaleSamples(0), mShareWarmup(0), mShareHopsLeft(0)
+    , mStartBin(0), mEndBin(0), mAverageReset(true)
+    , mInjectedLevels(nullptr), mInjectedCount(0)
+    , mEvents(nullptr), mSampleClock(0), mSimd(&FrequencyGateSimd::backend(simd))
+{
+    for (int c = 0; c < MAX_CHANNELS; c++) {
+        fChannelWeight[c] = 1.0f;
+        mSpectrumPtrs[c] = nullptr;
+    }
+#ifdef USE_PFFFT
+    for (int k = 0; k < kFFTSizeCount; k++) {
+        mSetups[k] = nullptr;
+        mPairSetups[k] = nullptr;
+        mSetupSizes[k] = 0;
+    }
+#endif
+    mMixBuffer.assign(MAX_HOP_SIZE, 0.0f);
+    mGainBuffer.assign(MAX_HOP_SIZE, 0.0f);
+    mAttackPowers.assign(kEnvelopeTableSize + 1, 0.0f);
+    mReleasePowers.assign(kEnvelopeTableSize + 1, 0.0f);
+}
+
+FrequencyGateDSP::~FrequencyGateDSP() { leaveShareGroup(); freeFFT(); freeSetups(); }
+
+// FFT Management
+// Called from the audio thread when the FFT size or gate mode changes, so it only selects
+// and clears buffers that prepareBuffers() allocated up front
+void FrequencyGateDSP::initFFT()
+{
+    mStats.addReinit();
+    const int option = std::max(0, std::min(kFFTSizeCount - 1, static_cast<int>(fFFTSizeOption)));
+    mCurrentFFTSize = getFFTSizeForRate(option, mSampleRate);
+    mHopSize = mCurrentFFTSize / FFT_OVERLAP;
+    
+    // Buffers and setups are normally prepared by activate() / setSampleRate(); they are
+    // only allocated here if those were skipped
+    if (mCurrentFFTSize > mBufferCapacity) prepareBuffers();
+    
+#ifdef USE_PFFFT
+    if (mSetupSizes[option] != mCurrentFFTSize) {
+        if (mSetups[option]) mSimd->destroySetup(mSetups[option]);
+        if (mPairSetups[option]) mSimd->destroySetup(mPairSetups[option]);
+        mSetups[option] = mSimd->newSetup(mCurrentFFTSize, PFFFT_REAL);
+        mPairSetups[option] = mSimd->newSetup(mCurrentFFTSize, PFFFT_COMPLEX);
+        mSetupSizes[option] = mCurrentFFTSize;
+    }
+    mPffftSetup = mSetups[option];
+    mPairSetup = mPairSetups[option];
+#endif
+    
+    // Twice the FFT size: per-channel detection runs complex transforms in them
+    if (mFftInput) std::memset(mFftInput, 0, 2 * mCurrentFFTSize * sizeof(float));
+    if (mFftOutput) std::memset(mFftOutput, 0, 2 * mCurrentFFTSize * sizeof(float));
+    if (mWorkBuffer) std::memset(mWorkBuffer, 0, 2 * mCurrentFFTSize * sizeof(float));
+    
+    // Broadband mode only keeps the detection key; spectral mode resynthesizes every channel
+    const size_t bufSize = mCurrentFFTSize * 2;
+    mInputBuffer.assign(bufSize, 0.0f);
+    const bool spectral = isSpectralMode();
+    if (spectral) {
+        if (mSpectra) std::memset(mSpectra, 0, mNumChannels * mCurrentFFTSize * sizeof(float));
+        mChannelBuffers.assign(mNumChannels * bufSize, 0.0f);
+        mOutputBuffers.assign(mNumChannels * mCurrentFFTSize, 0.0f);
+    } else {
+        mChannelBuffers.clear();
+        mOutputBuffers.clear();
+    }
+    for (int c = 0; c < mNumChannels; c++)
+        mSpectrumPtrs[c] = spectral && mSpectra ? mSpectra + c * mCurrentFFTSize : nullptr;
+    // Per-channel detection buffers each key channel (main or sidechain pair)
+    if (isPerChannelDetect()) mKeyBuffers.assign(std::max(mNumChannels, 2) * bufSize, 0.0f);
+    else mKeyBuffers.clear();
+    mKeySilentSamples = mCurrentFFTSize;  // Buffers start out silent
+    
+    mWindow.resize(mCurrentFFTSize);
+    mWindowSum.resize(mCurrentFFTSize, 0.0f);
+    createWindow();
+    
+    mMagnitudes.resize(mCurrentFFTSize / 2 + 1, 0.0f);
+    mAvgMagnitudes.assign(mCurrentFFTSize / 2 + 1, 0.0f);
+    mAverageReset = true;
+    mBinPower.assign(mCurrentFFTSize / 2 + 1, 0.0f);
+    mChannelPower.assign(2 * (mCurrentFFTSize / 2 + 1), 0.0f);
+    mBandPower.assign(mCurrentFFTSize / 2 + 1, 0.0f);
+    mMaskGain.assign(mCurrentFFTSize / 2 + 1, dbToLinear(fRange));
+    
+    const double hopMs = 1000.0 * mHopSize / mSampleRate;
+    mFloorTracker.prepare(static_cast<int>(std::ceil(AUTO_FLOOR_WINDOW_MS / hopMs)),
+                          static_cast<float>(std::exp(-hopMs / AUTO_FLOOR_SMOOTH_MS)));
+    mFloorWarmupHops = FFT_OVERLAP;
+    fNoiseFloor = -96.0f;
+    mInputWritePos = 0;
+    // A hop phase only moves the hop boundaries: spectral output is read from the same ring
+    // position it was written to, so the latency stays one frame and decisions stay within a hop
+    mHopCounter = std::max(0, std::min(mHopSize - 1, static_cast<int>(mHopPhase * mHopSize)));
+    
+    computeBandBins();
+    mNeedsBandUpdate = false;
+    
+    resizeLookahead();
+}
+
+// Allocate every buffer for the largest FFT size and the longest Pre-Open at the current
+// sample rate. Runs off the audio thread (activate(), setSampleRate()); afterwards FFT size,
+// gate mode, Pre-Open and band changes only reuse this storage.
+void FrequencyGateDSP::prepareBuffers()
+{
+    int maxSize = 0, minSize = MAX_FFT_SIZE;
+    for (int k = 0; k < kFFTSizeCount; k++) {
+        maxSize = std::max(maxSize, getFFTSizeForRate(k, mSampleRate));
+        minSize = std::min(minSize, getFFTSizeForRate(k, mSampleRate));
+    }
+    if (maxSize > mBufferCapacity) {
+        freeFFT();
+        mFftInput = static_cast<float*>(alignedAlloc(2 * maxSize * sizeof(float)));
+        mFftOutput = static_cast<float*>(alignedAlloc(2 * maxSize * sizeof(float)));
+        mWorkBuffer = static_cast<float*>(alignedAlloc(2 * maxSize * sizeof(float)));
+        mSpectra = static_cast<float*>(alignedAlloc(mNumChannels * maxSize * sizeof(float)));
+        mBufferCapacity = maxSize;
+    }
+    
+    const size_t maxBins = maxSize / 2 + 1;
+    mInputBuffer.reserve(maxSize * 2);
+    mChannelBuffers.reserve(mNumChannels * maxSize * 2);
+    mKeyBuffers.reserve(std::max(mNumChannels, 2) * maxSize * 2);
+    mOutputBuffers.reserve(mNumChannels * maxSize);
+    mWindow.reserve(maxSize);
+    mWindowSum.reserve(maxSize);
+    for (std::vector<float>* bins : { &mMagnitudes, &mAvgMagnitudes, &mBinPower, &mMaskGain, &mSortBuffer, &mBandPower })
+        bins->reserve(maxBins);
+    mChannelPower.reserve(2 * maxBins);
+    
+    // The smallest hop needs the longest noise floor window
+    const double minHopMs = 1000.0 * (minSize / FFT_OVERLAP) / mSampleRate;
+    mFloorTracker.reserve(static_cast<int>(std::ceil(AUTO_FLOOR_WINDOW_MS / minHopMs)));
+    mLookaheadBuffer.reserve(mNumChannels * static_cast<int>(MAX_PREOPEN_MS * mSampleRate / 1000.0));
+}
+
+// Structural changes requested by setParameter() take effect at the start of a block,
+// so they never run concurrently with the audio thread
+void FrequencyGateDSP::applyPendingChanges()
+{
+    if (mNeedsReinit) reinitFFT();
+    if (mNeedsBandUpdate) {
+        computeBandBins();
+        mNeedsBandUpdate = false;
+    }
+    if (mNeedsLookaheadResize) resizeLookahead();
+}
+
+int FrequencyGateDSP::lookaheadSamples() const
+{
+    const float ms = std::max(0.0f, std::min(fPreOpen, static_cast<float>(MAX_PREOPEN_MS)));
+    return static_cast<int>(ms * mSampleRate / 1000.0);
+}
+
+void FrequencyGateDSP::resizeLookahead()
+{
+    mLookaheadSamples = lookaheadSamples();
+    if (mLookaheadSamples > 0) mLookaheadBuffer.assign(mNumChannels * mLookaheadSamples, 0.0f);
+    else mLookaheadBuffer.clear();
+    mLookaheadWritePos = 0;
+    mNeedsLookaheadResize = false;
+}
+
+void FrequencyGateDSP::freeFFT()
+{
+#ifdef USE_PFFFT
+    mPffftSetup = nullptr;
+    mPairSetup = nullptr;
+#endif
+    alignedFree(mFftInput); mFftInput = nullptr;
+    alignedFree(mFftOutput); mFftOutput = nullptr;
+    alignedFree(mWorkBuffer); mWorkBuffer = nullptr;
+    alignedFree(mSpectra); mSpectra = nullptr;
+    for (int c = 0; c < mNumChannels; c++) mSpectrumPtrs[c] = nullptr;
+}
+
+void FrequencyGateDSP::reinitFFT() { initFFT(); mNeedsReinit = false; }
+
+// Build the setups of every size option for the current sample rate, so switching the
+// FFT size on the audio thread never has to create one
+void FrequencyGateDSP::prepareSetups()
+{
+#ifdef USE_PFFFT
+    for (int k = 0; k < kFFTSizeCount; k++) {
+        const int size = getFFTSizeForRate(k, mSampleRate);
+        if (mSetupSizes[k] == size) continue;
+        if (mSetups[k] == mPffftSetup) mPffftSetup = nullptr;   // Rebuilt by the pending reinit
+        if (mPairSetups[k] == mPairSetup) mPairSetup = nullptr;
+        if (mSetups[k]) mSimd->destroySetup(mSetups[k]);
+        if (mPairSetups[k]) mSimd->destroySetup(mPairSetups[k]);
+        mSetups[k] = mSimd->newSetup(size, PFFFT_REAL);
+        mPairSetups[k] = mSimd->newSetup(size, PFFFT_COMPLEX);
+        mSetupSizes[k] = size;
+    }
+#endif
+}
+
+void FrequencyGateDSP::freeSetups()
+{
+#ifdef USE_PFFFT
+    for (int k = 0; k < kFFTSizeCount; k++) {
+        if (mSetups[k]) mSimd->destroySetup(mSetups[k]);
+        if (mPairSetups[k]) mSimd->destroySetup(mPairSetups[k]);
+        mSetups[k] = nullptr;
+        mPairSetups[k] = nullptr;
+        mSetupSizes[k] = 0;
+    }
+    mPffftSetup = nullptr;
+    mPairSetup = nullptr;
+#endif
+}
+
+void FrequencyGateDSP::createWindow()
+{
+    // Hann window
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+    float sum = 0.0f;
+    float sumSq = 0.0f;
+    for (int i = 0; i < mCurrentFFTSize; i++) {
+        mWindow[i] = 0.5f * (1.0f - std::cos(twoPi * i / (mCurrentFFTSize - 1)));
+        sum += mWindow[i];
+        sumSq += mWindow[i] * mWindow[i];
+    }
+    // Coherent gain compensation: Hann ~= 0.5, so multiply by ~2
+    mWindowGain = static_cast<float>(mCurrentFFTSize) / sum;
+    
+    // Spectral mode uses the same window for analysis and synthesis. Overlapping
+    // Hann^2 frames sum to sumSq / hop; PFFFT's inverse is unnormalized, so fold 1/N in too.
+    mOlaGain = static_cast<float>(mHopSize) / (sumSq * mCurrentFFTSize);
+}
+
+void FrequencyGateDSP::computeBandBins()
+{
+    const double binWidth = mSampleRate / mCurrentFFTSize;
+    const int nyquistBin = mCurrentFFTSize / 2;
+    const double nyquistFreq = mSampleRate / 2.0;
+    
+    double lowFreq = std::max(20.0, static_cast<double>(fFreqLow));
+    double highFreq = std::min(nyquistFreq, static_cast<double>(fFreqHigh));
+    if (lowFreq >= highFreq) highFreq = lowFreq + binWidth;
+    
+    mStartBin = std::max(1, static_cast<int>(std::floor(lowFreq / binWidth)));
+    mEndBin = std::min(nyquistBin, static_cast<int>(std::ceil(highFreq / binWidth)));
+    if (mEndBin <= mStartBin) mEndBin = mStartBin + 1;
+    mAverageReset = true;
+}
+
+// Level detection
+float FrequencyGateDSP::linearToDb(float linear)
+{
+    if (linear < 1e-10f) return -96.0f;
+    return std::max(-96.0f, 20.0f * std::log10(linear));
+}
+
+float FrequencyGateDSP::dbToLinear(float db)
+{
+    if (db <= -96.0f) return 0.0f;
+    return std::pow(10.0f, db / 20.0f);
+}
+
+float FrequencyGateDSP::getOpenThreshold() const
+{
+    if (fAutoThreshold < 0.5f) return fThreshold;
+    return std::max(-96.0f, std::min(0.0f, fNoiseFloor + fAutoMargin));
+}
+
+float FrequencyGateDSP::detectLevel()
+{
+#ifdef USE_PFFFT
+    if (!mPffftSetup || !mFftInput || !mFftOutput) return -96.0f;
+    
+    mSimd->transformOrdered(mPffftSetup, mFftInput, mFftOutput, mWorkBuffer, PFFFT_FORWARD);
+    return measureBandLevel();
+#else
+    return -96.0f;
+#endif
+}
+
+// Spectral mode analysis: transform each channel separately (the spectra are reused for
+// resynthesis) and rebuild the weighted detection spectrum from them, since the FFT is linear.
+// Per-channel detection reads the channel spectra directly. A sidechain key gets its own
+// transform; a silent key skips detection altogether.
+float FrequencyGateDSP::analyzeSpectralHop(bool sidechainKey, bool perChannel, bool keySilent)
+{
+#ifdef USE_PFFFT
+    if (!mPffftSetup || !mFftInput || !mFftOutput || !mSpectra) return -96.0f;
+    
+    const int N = mCurrentFFTSize;
+    const int readPos = mInputWritePos;
+    for (int c = 0; c < mNumChannels; c++) {
+        mSimd->applyWindow(mFftInput, &mChannelBuffers[c * 2 * N + readPos], mWindow.data(), N);
+        mSimd->transformOrdered(mPffftSetup, mFftInput, mSpectra + c * N, mWorkBuffer, PFFFT_FORWARD);
+    }
+    
+    if (keySilent) return -96.0f;
+    if (perChannel) return analyzeChannelsHop(sidechainKey, !sidechainKey);
+    if (sidechainKey) {
+        mSimd->applyWindow(mFftInput, &mInputBuffer[readPos], mWindow.data(), N);
+        return detectLevel();
+    }
+    mSimd->weightedMean(mFftOutput, mSpectrumPtrs, fChannelWeight, mNumChannels, 0, N);
+    return measureBandLevel();
+#else
+    return -96.0f;
+#endif
+}
+
+// Spectral mode resynthesis: update the per-bin gain mask (linked across channels), apply it
+// to every channel spectrum and overlap-add the inverse transforms into the accumulators.
+void FrequencyGateDSP::synthesizeSpectralHop(float thresholdDb, float rangeGain,
+                                             float attackCoeff, float releaseCoeff)
+{
+#ifdef USE_PFFFT
+    if (!mPffftSetup || !mFftInput || !mSpectra) return;
+    
+    const int N = mCurrentFFTSize;
+    const int halfSize = N / 2;
+    
+    // A bin stays open while its own level is above the threshold (the caller passes the
+    // close threshold, so bins pass for as long as the broadband gate would hold); compare raw
+    // power against the threshold mapped into unnormalized FFT units (no sqrt/log per bin).
+    const float binMag = dbToLinear(thresholdDb) * N / (2.0f * mWindowGain);
+    mSimd->binPower(mBinPower.data(), mSpectra, N);
+    for (int c = 1; c < mNumChannels; c++)
+        mSimd->maxBinPower(mBinPower.data(), mSpectra + c * N, N);
+    mSimd->smoothMask(mMaskGain.data(), mBinPower.data(), binMag * binMag,
+                      mGateOpen, rangeGain, attackCoeff, releaseCoeff, halfSize + 1);
+    
+    // Frame sample j belongs at ring position (mInputWritePos + j) % N
+    const int head = N - mInputWritePos;
+    for (int c = 0; c < mNumChannels; c++) {
+        float* spectrum = mSpectra + c * N;
+        float* ola = &mOutputBuffers[c * N];
+        mSimd->applyMask(spectrum, mMaskGain.data(), N);
+        mSimd->transformOrdered(mPffftSetup, spectrum, mFftInput, mWorkBuffer, PFFFT_BACKWARD);
+        mSimd->overlapAdd(ola + mInputWritePos, mFftInput, mWindow.data(), mOlaGain, head);
+        mSimd->overlapAdd(ola, mFftInput + head, mWindow.data() + head, mOlaGain, N - head);
+    }
+#endif
+}
+
+float FrequencyGateDSP::measureBandLevel()
+{
+    // PFFFT real FFT output (ordered):
+    // [0] = DC, [1] = Nyquist, [2k] = Re(k), [2k+1] = Im(k) for k=1..N/2-1
+    
+    // Normalization: divide by N, multiply by 2 for single-sided (except DC/Nyquist)
+    // Also apply window gain compensation
+    const int N = mCurrentFFTSize;
+    const int halfSize = N / 2;
+    
+    int binCount = 0;
+    for (int bin = mStartBin; bin <= mEndBin && bin <= halfSize; bin++) {
+        float re, im;
+        
+        if (bin == 0) {
+            re = mFftOutput[0] / N * mWindowGain;
+            im = 0.0f;
+        } else if (bin == halfSize) {
+            re = mFftOutput[1] / N * mWindowGain;
+            im = 0.0f;
+        } else {
+            // Single-sided: multiply by 2
+            re = mFftOutput[bin * 2] * 2.0f / N * mWindowGain;
+            im = mFftOutput[bin * 2 + 1] * 2.0f / N * mWindowGain;
+        }
+        
+        // Magnitude (amplitude)
+        mMagnitudes[bin] = std::sqrt(re * re + im * im);
+        binCount++;
+    }
+    return detectBandLevel(binCount);
+}
+
+// Per-channel detection: the band power of every key channel with a weight > 0, combined per
+// bin. Channels are transformed in pairs, one in the real and one in the imaginary part of a
+// complex FFT, and split again by conjugate symmetry over the band bins only; that costs about
+// one real transform per channel. Spectral mode with the main key reuses the channel spectra.
+float FrequencyGateDSP::analyzeChannelsHop(bool sidechainKey, bool useSpectra)
+{
+#ifdef USE_PFFFT
+    if (!mPffftSetup || !mPairSetup || !mFftInput || !mFftOutput) return -96.0f;
+    if (useSpectra && !mSpectra) return -96.0f;
+    
+    const int N = mCurrentFFTSize;
+    const int binCount = std::min(mEndBin, N / 2) - mStartBin + 1;
+    if (binCount <= 0) return -96.0f;
+    
+    const int channels = sidechainKey ? 2 : mNumChannels;
+    const float* weights = sidechainKey ? kSidechainWeights : fChannelWeight;
+    int keys[MAX_CHANNELS];
+    int keyCount = 0;
+    float weightSum = 0.0f;
+    for (int c = 0; c < channels; c++) {
+        if (weights[c] <= 0.0f) continue;
+        keys[keyCount++] = c;
+        weightSum += weights[c];
+    }
+    if (keyCount == 0) return -96.0f;
+    
+    const int mode = static_cast<int>(fChannelDetect);
+    float* band = mBandPower.data();
+    float* powerA = mChannelPower.data();
+    float* powerB = powerA + binCount;
+    mSimd->fill(band, 0.0f, binCount);
+    auto combine = [&](const float* power, float weight) {
+        if (mode == kChannelMax) mSimd->maxPower(band, power, weight * weight, binCount);
+        else if (mode == kChannelMean) mSimd->accumulateMagnitude(band, power, weight, binCount);
+        else mSimd->accumulate(band, power, weight, binCount);
+    };
+    
+    const int readPos = mInputWritePos;
+    const float* ring = mKeyBuffers.data();
+    int k = 0;
+    if (useSpectra) {
+        for (; k < keyCount; k++) {
+            mSimd->bandPower(powerA, mSpectra + keys[k] * N, N, mStartBin, binCount);
+            combine(powerA, weights[keys[k]]);
+        }
+    }
+    for (; k + 1 < keyCount; k += 2) {
+        mSimd->packPair(mFftInput, ring + keys[k] * 2 * N + readPos,
+                        ring + keys[k + 1] * 2 * N + readPos, mWindow.data(), N);
+        mSimd->transformOrdered(mPairSetup, mFftInput, mFftOutput, mWorkBuffer, PFFFT_FORWARD);
+        mSimd->pairBandPower(powerA, powerB, mFftInput, mFftOutput, N, mStartBin, binCount);
+        combine(powerA, weights[keys[k]]);
+        combine(powerB, weights[keys[k + 1]]);
+    }
+    if (k < keyCount) {
+        // Odd channel out: a real transform
+        mSimd->applyWindow(mFftInput, ring + keys[k] * 2 * N + readPos, mWindow.data(), N);
+        mSimd->transformOrdered(mPffftSetup, mFftInput, mFftOutput, mWorkBuffer, PFFFT_FORWARD);
+        mSimd->bandPower(powerA, mFftOutput, N, mStartBin, binCount);
+        combine(powerA, weights[keys[k]]);
+    }
+    
+    // Back to single-sided amplitudes as in measureBandLevel(): 2/N (1/N at Nyquist), window gain
+    const float amp = 2.0f / N * mWindowGain;
+    float* mags = &mMagnitudes[mStartBin];
+    if (mode == kChannelMean) mSimd->scale(mags, band, amp / weightSum, binCount);
+    else mSimd->scaledSqrt(mags, band, amp * amp / (mode == kChannelMax ? 1.0f : weightSum), binCount);
+    if (mStartBin + binCount - 1 == N / 2) mags[binCount - 1] *= 0.5f;
+    return detectBandLevel(binCount);
+#else
+    (void)sidechainKey; (void)useSpectra;
+    return -96.0f;
+#endif
+}
+
+// Averaging and the detection method over the band magnitudes in mMagnitudes
+float FrequencyGateDSP::detectBandLevel(int binCount)
+{
+    if (binCount <= 0) return -96.0f;
+    
+    // Averaging across hops: a short FFT gets the steady band level of a long one without its
+    // latency. Only the band bins are touched; every detection method sees the averaged values.
+    if (fAveraging > 0.0f) {
+        if (mAverageReset) {
+            std::copy(&mMagnitudes[mStartBin], &mMagnitudes[mStartBin] + binCount, &mAvgMagnitudes[mStartBin]);
+            mAverageReset = false;
+        }
+        const float hopMs = static_cast<float>(1000.0 * mHopSize / mSampleRate);
+        mSimd->averageSpectrum(&mMagnitudes[mStartBin], &mAvgMagnitudes[mStartBin],
+                               std::exp(-hopMs / fAveraging), binCount);
+    }
+    
+    // Apply detection method on LINEAR magnitudes
+    float level = 0.0f;
+    switch (static_cast<int>(fDetectionMethod)) {
+        case kDetectPeak:
+            level = computePeak(mMagnitudes, mStartBin, binCount);
+            break;
+        case kDetectMedian:
+            level = computeMedian(mMagnitudes, mStartBin, binCount);
+            break;
+        case kDetectRMS:
+            level = computeRMS(mMagnitudes, mStartBin, binCount);
+            break;
+        case kDetectTrimmedMean:
+            level = computeTrimmedMean(mMagnitudes, mStartBin, binCount);
+            break;
+        case kDetectFlatness: {
+            const float flatness = computeFlatness(mMagnitudes, mStartBin, binCount);
+            const float voicing = (flatness < 0.0f) ? 1.0f  // Resolution too coarse to judge
+                : (kFlatnessNoise - flatness) / (kFlatnessNoise - kFlatnessVoiced);
+            level = computeAverage(mMagnitudes, mStartBin, binCount) * voicingWeight(voicing);
+            break;
+        }
+        case kDetectHarmonic: {
+            const float harmonicity = computeHarmonicity(mMagnitudes, mStartBin, binCount);
+            const float voicing = (harmonicity < 0.0f) ? 1.0f  // Too few or too coarse bins for a comb
+                : (harmonicity - kHarmonicityNoise) / (kHarmonicityVoiced - kHarmonicityNoise);
+            level = computeAverage(mMagnitudes, mStartBin, binCount) * voicingWeight(voicing);
+            break;
+        }
+        case kDetectAverage:
+        default:
+            level = computeAverage(mMagnitudes, mStartBin, binCount);
+            break;
+    }
+    
+    // Convert to dBFS
+    return linearToDb(level);
+}
+
+// Detection algorithms
+float FrequencyGateDSP::computeAverage(const std::vector<float>& mags, int start, int count)
+{
+    if (count <= 0) return 0.0f;
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) sum += mags[start + i];
+    return sum / count;
+}
+
+float FrequencyGateDSP::computePeak(const std::vector<float>& mags, int start, int count)
+{
+    if (count <= 0) return 0.0f;
+    float peak = 0.0f;
+    for (int i = 0; i < count; i++) {
+        if (mags[start + i] > peak) peak = mags[start + i];
+    }
+    return peak;
+}
+
+// Selection instead of a full sort; the scratch buffer is preallocated (prepareBuffers())
+float FrequencyGateDSP::computeMedian(std::vector<float>& mags, int start, int count)
+{
+    if (count <= 0) return 0.0f;
+    mSortBuffer.assign(mags.begin() + start, mags.begin() + start + count);
+    float* temp = mSortBuffer.data();
+    std::nth_element(temp, temp + count / 2, temp + count);
+    const float upper = temp[count / 2];
+    if (count % 2 != 0) return upper;
+    return (*std::max_element(temp, temp + count / 2) + upper) * 0.5f;
+}
+
+float FrequencyGateDSP::computeRMS(const std::vector<float>& mags, int start, int count)
+{
+    if (count <= 0) return 0.0f;
+    float sumSq = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float m = mags[start + i];
+        sumSq += m * m;
+    }
+    return std::sqrt(sumSq / count);
+}
+
+float FrequencyGateDSP::computeTrimmedMean(std::vector<float>& mags, int start, int count)
+{
+    if (count <= 4) return computeAverage(mags, start, count);
+    mSortBuffer.assign(mags.begin() + start, mags.begin() + start + count);
+    float* temp = mSortBuffer.data();
+    int trim = std::max(1, count / 10);
+    int tc = count - 2 * trim;
+    if (tc <= 0) return computeAverage(mags, start, count);
+    // Two selections leave the middle values in [trim, count - trim), in no particular order
+    std::nth_element(temp, temp + trim, temp + count);
+    std::nth_element(temp + trim, temp + count - trim, temp + count);
+    return mSimd->sum(temp + trim, tc) / tc;
+}
+
+// Spectral flatness: geometric mean / arithmetic mean of the band magnitudes.
+// Near 1 for broadband noise, low for the peaky spectrum of voiced speech.
+// Returns -1 when the bins are too coarse to separate voice harmonics.
+float FrequencyGateDSP::computeFlatness(const std::vector<float>& mags, int start, int count)
+{
+    if (count <= 4 || mSampleRate / mCurrentFFTSize > kFeatureMaxBinWidth) return -1.0f;
+    const float arith = mSimd->sum(&mags[start], count) / count;
+    if (arith <= 1e-10f) return 1.0f;
+    const float geo = std::exp2(mSimd->sumLog2(&mags[start], count) / count);
+    return geo / arith;
+}
+
+// Harmonic comb salience: for each candidate fundamental, the mean magnitude at its
+// harmonics inside the band (peak of the two nearest bins), relative to the band mean.
+// Returns the best score, or -1 when the band cannot hold two resolved harmonics.
+float FrequencyGateDSP::computeHarmonicity(const std::vector<float>& mags, int start, int count)
+{
+    if (count <= 4 || mSampleRate / mCurrentFFTSize > kFeatureMaxBinWidth) return -1.0f;
+    const float bandMean = mSimd->sum(&mags[start], count) / count;
+    if (bandMean <= 1e-10f) return 0.0f;
+    
+    const float binWidth = static_cast<float>(mSampleRate / mCurrentFFTSize);
+    const int end = start + count - 1;
+    const float minPeriod = std::max(2.0f, kPitchMinHz / binWidth);
+    const float maxPeriod = kPitchMaxHz / binWidth;
+    
+    float best = -1.0f;
+    for (float period = minPeriod; period <= maxPeriod; period += 0.5f) {
+        float combSum = 0.0f;
+        int harmonics = 0;
+        for (int h = static_cast<int>(std::ceil(start / period)); h * period <= end; h++) {
+            const int bin = static_cast<int>(h * period);
+            combSum += std::max(mags[bin], mags[std::min(bin + 1, end)]);
+            harmonics++;
+        }
+        if (harmonics >= 2) best = std::max(best, combSum / (harmonics * bandMean));
+    }
+    return best;
+}
+
+float FrequencyGateDSP::voicingWeight(float voicing)
+{
+    voicing = std::max(0.0f, std::min(1.0f, voicing));
+    return kVoicingFloor + (1.0f - kVoicingFloor) * voicing;
+}
+
+float FrequencyGateDSP::getParameter(uint32_t index) const
+{
+    switch (index) {
+        case kParamFreqLow: return fFreqLow;
+        case kParamFreqHigh: return fFreqHigh;
+        case kParamThreshold: return fThreshold;
+        case kParamDetectionMethod: return fDetectionMethod;
+        case kParamPreOpen: return fPreOpen;
+        case kParamAttack: return fAttack;
+        case kParamHold: return fHold;
+        case kParamRelease: return fRelease;
+        case kParamHysteresis: return fHysteresis;
+        case kParamRange: return fRange;
+        case kParamFFTSize: return fFFTSizeOption;
+        case kParamGateMode: return fGateMode;
+        case kParamAutoThreshold: return fAutoThreshold;
+        case kParamAutoMargin: return fAutoMargin;
+        case kParamNoiseFloor: return fNoiseFloor;
+        case kParamShareGroup: return fShareGroup;
+        case kParamKeySource: return fKeySource;
+        case kParamAveraging: return fAveraging;
+        case kParamChannelDetect: return fChannelDetect;
+        default:
+            if (index >= kParamChannelWeight0 && index < static_cast<uint32_t>(kParamChannelWeight0 + mNumChannels))
+                return fChannelWeight[index - kParamChannelWeight0];
+            return 0.0f;
+    }
+}
+
+void FrequencyGateDSP::setParameter(uint32_t index, float value)
+{
+    switch (index) {
+        case kParamFreqLow: fFreqLow = value; mNeedsBandUpdate = true; break;
+        case kParamFreqHigh: fFreqHigh = value; mNeedsBandUpdate = true; break;
+        case kParamThreshold: fThreshold = value; break;
+        case kParamDetectionMethod: fDetectionMethod = value; break;
+        case kParamPreOpen:
+            if (fPreOpen != value) {
+                fPreOpen = value;
+                mNeedsLookaheadResize = true;
+            }
+            break;
+        case kParamAttack: fAttack = value; break;
+        case kParamHold: fHold = value; break;
+        case kParamRelease: fRelease = value; break;
+        case kParamHysteresis: fHysteresis = value; break;
+        case kParamRange: fRange = value; break;
+        case kParamFFTSize:
+            if (static_cast<int>(fFFTSizeOption) != static_cast<int>(value)) {
+                fFFTSizeOption = value;
+                mNeedsReinit = true;
+            }
+            break;
+        case kParamGateMode:
+            if (static_cast<int>(fGateMode) != static_cast<int>(value)) {
+                fGateMode = value;
+                mNeedsReinit = true;  // Restart the overlap-add path and report the new latency
+            }
+            break;
+        case kParamAutoThreshold: fAutoThreshold = value; break;
+        case kParamAutoMargin: fAutoMargin = value; break;
+        case kParamShareGroup: fShareGroup = value; break;
+        case kParamKeySource: fKeySource = value; break;
+        case kParamAveraging:
+            if (fAveraging <= 0.0f && value > 0.0f) mAverageReset = true;
+            fAveraging = value;
+            break;
+        case kParamChannelDetect:
+            // Switching to or from Mix changes which key buffers are kept
+            if ((static_cast<int>(fChannelDetect) == kChannelMix) != (static_cast<int>(value) == kChannelMix))
+                mNeedsReinit = true;
+            fChannelDetect = value;
+            break;
+        default:
+            if (index >= kParamChannelWeight0 && index < static_cast<uint32_t>(kParamChannelWeight0 + mNumChannels))
+                fChannelWeight[index - kParamChannelWeight0] = value;
+            break;
+    }
+}
+
+// Processing
+void FrequencyGateDSP::activate()
+{
+    prepareSetups();
+    prepareBuffers();
+    initFFT();
+    mNeedsReinit = false;
+    mEnvelopeLevel = 0.0f;
+    mGateGain = dbToLinear(fRange);
+    mGateOpen = false;
+    mHoldCounter = 0;
+    mEnvelopeCoeff = 0.0f;
+    mEnvelopeSteps = 0;
+    
+    // The first block logs every parameter, so the log starts from a known state
+    mSampleClock = 0;
+    for (float& value : mLoggedParams) value = std::nanf("");
+    logEvent(kEventStart, static_cast<float>(mSampleRate));
+}
+
+void FrequencyGateDSP::deactivate() { leaveShareGroup(); }
+
+void FrequencyGateDSP::setSampleRate(double newSampleRate)
+{
+    if (newSampleRate == mSampleRate) return;
+    mSampleRate = newSampleRate;
+    prepareSetups();
+    prepareBuffers();
+    mNeedsReinit = true;
+}
+
+uint32_t FrequencyGateDSP::getLatency() const
+{
+    // Spectral mode delays by one full frame (overlap-add); Pre-Open is implicit there
+    // because the mask is computed from the same frame it is applied to. Broadband audio
+    // only passes the Pre-Open delay line: the hop is detection delay, not audio delay.
+    if (isSpectralMode()) return static_cast<uint32_t>(mCurrentFFTSize);
+    return static_cast<uint32_t>(lookaheadSamples());   // Reported as soon as Pre-Open changes
+}
+
+bool FrequencyGateDSP::canSplitAnalysis() const
+{
+    // Spectral mode resynthesizes from its own analysis, a share group depends on other instances,
+    // and averaged levels depend on every earlier hop, not just the last frame
+    return !isSpectralMode() && static_cast<int>(fShareGroup) == 0 && fAveraging <= 0.0f;
+}
+
+// Shared analysis bus
+// Called once per block: joins/leaves groups, and promotes this instance to leader when
+// the group has none or its leader stopped publishing (bypassed, stalled or removed).
+void FrequencyGateDSP::updateShareRole(uint32_t frames)
+{
+    const int group = static_cast<int>(fShareGroup);
+    if (group != mShareGroup) {
+        leaveShareGroup();
+        mShareGroup = (group >= 1 && group <= MAX_SHARE_GROUPS) ? group : 0;
+    }
+    if (mShareGroup == 0) return;
+    
+    const SharedAnalysisBus::Decision d = SharedAnalysisBus::read(mShareGroup);
+    if (d.seq != mShareSeenSeq) {
+        mShareSeenSeq = d.seq;
+        mShareStaleSamples = 0;
+    } else {
+        mShareStaleSamples += static_cast<int>(frames);
+    }
+    
+    const void* leader = SharedAnalysisBus::leader(mShareGroup);
+    if (leader == this) {
+        mShareRole = kShareLeader;
+        return;
+    }
+    
+    const int staleLimit = std::max(static_cast<int>(mSampleRate * SHARE_STALE_MS / 1000.0),
+                                    2 * static_cast<int>(frames));
+    if ((leader == nullptr || mShareStaleSamples > staleLimit)
+        && SharedAnalysisBus::claim(mShareGroup, leader, this)) {
+        // A former follower has not been filling its analysis buffer
+        if (mShareRole == kShareFollower) mShareWarmup = mCurrentFFTSize;
+        mShareRole = kShareLeader;
+        mShareSeq = d.seq;
+        mShareStaleSamples = 0;
+        return;
+    }
+    
+    // Spectral mode needs its own per-bin analysis, so it never follows
+    if (isSpectralMode()) {
+        mShareRole = kShareNone;
+        return;
+    }
+    // Pick up the decisions the leader made this cycle (the first hop clamps how far back)
+    if (mShareRole != kShareFollower) mShareSeq = d.seq - SHARE_HISTORY;
+    mShareRole = kShareFollower;
+}
+
+void FrequencyGateDSP::leaveShareGroup()
+{
+    if (mShareRole == kShareLeader) SharedAnalysisBus::release(mShareGroup, this);
+    mShareGroup = 0;
+    mShareRole = kShareNone;
+    mShareWarmup = 0;
+}
+
+// One decision per hop, in order: a follower processed after its leader in the same cycle
+// makes the leader's decisions at the same hops. Decisions older than the hops left in the
+// block are skipped, so a follower never falls behind by more than a block.
+void FrequencyGateDSP::applySharedDecision()
+{
+    const uint32_t latest = SharedAnalysisBus::latest(mShareGroup);
+    const uint32_t pending = (latest - mShareSeq) & SharedAnalysisBus::kSeqMask;
+    const uint32_t keep = static_cast<uint32_t>(std::min(std::max(mShareHopsLeft, 1), SHARE_HISTORY));
+    if (mShareHopsLeft > 0) mShareHopsLeft--;
+    if (pending == 0) return;
+    if (pending > keep) mShareSeq = latest - keep;
+    
+    SharedAnalysisBus::Decision d;
+    if (!SharedAnalysisBus::read(mShareGroup, mShareSeq + 1, d)) d = SharedAnalysisBus::read(mShareGroup);
+    mShareSeq = d.seq;
+    if (d.open != mGateOpen) {
+        mStats.addTransition();
+        logEvent(d.open ? kEventOpen : kEventClose, d.level);
+    }
+    mGateOpen = d.open;
+    mHoldCounter = d.holding ? 1 : 0;
+    if (d.measured) fNoiseFloor = mFloorTracker.process(d.level);
+}
+
+// Parameter changes are picked up here, at block start on the audio thread, so the event
+// ring keeps a single producer however the host delivers parameters. Outputs are skipped.
+void FrequencyGateDSP::logParameterChanges()
+{
+    const uint32_t count = static_cast<uint32_t>(kParamChannelWeight0 + mNumChannels);
+    for (uint32_t index = 0; index < count; index++) {
+        if (index == kParamNoiseFloor || index == kParamDspLoad || index == kParamDspPeak) continue;
+        const float value = getParameter(index);
+        if (value == mLoggedParams[index]) continue;
+        mLoggedParams[index] = value;
+        logEvent(kEventParameter, value, static_cast<uint16_t>(index));
+    }
+}
+
+void FrequencyGateDSP::publishSharedDecision(float level, bool measured)
+{
+    SharedAnalysisBus::Decision d;
+    d.seq = ++mShareSeq;
+    d.open = mGateOpen;
+    d.holding = mHoldCounter > 0;
+    d.measured = measured;
+    d.level = level;
+    SharedAnalysisBus::publish(mShareGroup, d);
+}
+
+// Copy one segment into a doubled ring buffer, starting at the current write position
+void FrequencyGateDSP::writeRing(float* ring, const float* src, int count) const
+{
+    const int N = mCurrentFFTSize;
+    int pos = mInputWritePos;
+    while (count > 0) {
+        const int run = std::min(count, N - pos);
+        std::memcpy(ring + pos, src, run * sizeof(float));
+        std::memcpy(ring + pos + N, src, run * sizeof(float));
+        src += run;
+        count -= run;
+        pos = 0;
+    }
+}
+
+// Detection key: the weighted mix of the main channels, or the mono sidechain. Only this
+// mix is buffered for analysis, so broadband cost does not grow with the channel count.
+void FrequencyGateDSP::writeKey(const float** inputs, const BlockParams& bp, uint32_t offset, int count)
+{
+    if (bp.perChannel) {
+        writeChannelKeys(inputs, bp, offset, count);
+        return;
+    }
+    float* mix = mMixBuffer.data();
+    if (bp.sidechainKey)
+        mSimd->weightedMean(mix, inputs + mNumChannels, kSidechainWeights, 2, offset, count);
+    else
+        mSimd->weightedMean(mix, inputs, fChannelWeight, mNumChannels, offset, count);
+    
+    // Scalar on purpose: the scan stops at the last non-zero sample, usually the first it reads
+    const int silent = FrequencyGateKernels::trailingZeros(mix, count);
+    mKeySilentSamples = (silent == count) ? std::min(mKeySilentSamples + count, mCurrentFFTSize) : silent;
+    writeRing(mInputBuffer.data(), mix, count);
+}
+
+// Per-channel detection key: every key channel gets its own ring, except in spectral mode with
+// the main key, whose channel rings already hold it. The key is silent once every weighted
+// channel is.
+void FrequencyGateDSP::writeChannelKeys(const float** inputs, const BlockParams& bp, uint32_t offset, int count)
+{
+    const float* const* key = bp.sidechainKey ? inputs + mNumChannels : inputs;
+    const float* weights = bp.sidechainKey ? kSidechainWeights : fChannelWeight;
+    const int channels = bp.sidechainKey ? 2 : mNumChannels;
+    const bool buffered = bp.sidechainKey || !bp.spectral;
+    const int ringSize = 2 * mCurrentFFTSize;
+    
+    int silent = count;
+    for (int c = 0; c < channels; c++) {
+        const float* src = key[c] ? key[c] + offset : nullptr;
+        if (src && weights[c] > 0.0f) silent = std::min(silent, FrequencyGateKernels::trailingZeros(src, count));
+        if (!buffered) continue;
+        if (!src) {
+            // Unconnected port: silence
+            mSimd->fill(mMixBuffer.data(), 0.0f, count);
+            src = mMixBuffer.data();
+        }
+        writeRing(&mKeyBuffers[c * ringSize], src, count);
+    }
+    mKeySilentSamples = (silent == count) ? std::min(mKeySilentSamples + count, mCurrentFFTSize) : silent;
+}
+
+void FrequencyGateDSP::writeChannels(const float** inputs, uint32_t offset, int count)
+{
+    const int ringSize = 2 * mCurrentFFTSize;
+    for (int c = 0; c < mNumChannels; c++)
+        writeRing(&mChannelBuffers[c * ringSize], inputs[c] + offset, count);
+}
+
+// Spectral mode: the slots about to be overwritten hold fully overlap-added samples
+void FrequencyGateDSP::readSpectralOutput(float** outputs, uint32_t offset, int count)
+{
+    const int N = mCurrentFFTSize;
+    for (int c = 0; c < mNumChannels; c++) {
+        float* ola = &mOutputBuffers[c * N];
+        float* out = outputs[c] + offset;
+        int pos = mInputWritePos;
+        for (int left = count; left > 0; ) {
+            const int run = std::min(left, N - pos);
+            std::memcpy(out, ola + pos, run * sizeof(float));
+            std::memset(ola + pos, 0, run * sizeof(float));
+            out += run;
+            left -= run;
+            pos = 0;
+        }
+    }
+}
+
+// Detection level of the hop that just completed
+float FrequencyGateDSP::measureHopLevel(const BlockParams& bp)
+{
+    const bool keySilent = mKeySilentSamples >= mCurrentFFTSize;
+    if (keySilent) mAverageReset = true;   // Averaging restarts with the key
+    if (bp.spectral) return analyzeSpectralHop(bp.sidechainKey, bp.perChannel, keySilent);
+    if (keySilent) return -96.0f;
+    if (bp.perChannel) return analyzeChannelsHop(bp.sidechainKey, false);
+    
+    // Fill FFT input with the windowed key, oldest sample first
+    mSimd->applyWindow(mFftInput, &mInputBuffer[mInputWritePos], mWindow.data(), mCurrentFFTSize);
+    return detectLevel();
+}
+
+void FrequencyGateDSP::processHop(const BlockParams& bp)
+{
+    mHopCounter = 0;
+    mStats.addHop();
+    
+    // Followers skip the analysis buffer, FFT and detection; the leader's decisions drive them
+    if (bp.follower) {
+        applySharedDecision();
+        return;
+    }
+    // Newly promoted leader: keep the last shared decision alive until the buffer is full.
+    // No level was measured, so followers leave their floor trackers alone
+    if (mShareWarmup > 0) {
+        publishSharedDecision(SharedAnalysisBus::read(mShareGroup).level, false);
+        return;
+    }
+    
+    const uint64_t analysisStart = GateStats::now();
+    const float level = mInjectedLevels ? mInjectedLevels[mInjectedCount++] : measureHopLevel(bp);
+    
+    // Noise floor tracking: O(1) amortized per hop, published as an output parameter
+    if (mFloorWarmupHops > 0) mFloorWarmupHops--;
+    else fNoiseFloor = mFloorTracker.process(level);
+    
+    // Thresholds with hysteresis (Auto Threshold moves them at hop boundaries)
+    const float openThresh = getOpenThreshold();
+    const float closeThresh = openThresh - fHysteresis;
+    
+    // Gate logic with hysteresis
+    const bool wasOpen = mGateOpen;
+    bool shouldOpen = mGateOpen ? (level >= closeThresh) : (level >= openThresh);
+    
+    if (shouldOpen) {
+        mGateOpen = true;
+        mHoldCounter = bp.holdSamples;
+    } else if (mHoldCounter > 0) {
+        mHoldCounter -= mHopSize;   // Hold is in samples; decisions run once per hop
+        if (mHoldCounter <= 0) logEvent(kEventHoldExpired, level);
+    } else {
+        mGateOpen = false;
+    }
+    if (mGateOpen != wasOpen) {
+        mStats.addTransition();
+        logEvent(mGateOpen ? kEventOpen : kEventClose, level);
+    }
+    
+    if (bp.leader) publishSharedDecision(level);
+    // Per-bin mask at the close threshold: bins follow the hysteresis of the broadband decision
+    if (bp.spectral) synthesizeSpectralHop(closeThresh, bp.rangeGain, bp.maskAttackCoeff, bp.maskReleaseCoeff);
+    if (!mInjectedLevels) mStats.addAnalysis(analysisStart);
+}
+
+// Envelope follower: one gain per sample, shared by all channels. The target and the hold
+// state only change at hop boundaries, so the one-pole recursion is evaluated in closed form
+// from power tables. Curves restart at fixed sample counts, never at block boundaries, so the
+// output stays independent of the host's block size.
+void FrequencyGateDSP::renderGain(const BlockParams& bp, float* gains, int count)
+{
+    // Attack towards an open gate; release only once hold has run out
+    const float target = mGateOpen ? 1.0f : 0.0f;
+    float coeff = 0.0f;
+    const float* powers = nullptr;
+    if (target > mEnvelopeLevel) {
+        coeff = bp.attackCoeff;
+        powers = mAttackPowers.data();
+    } else if (mHoldCounter <= 0 && mEnvelopeLevel != target) {
+        coeff = bp.releaseCoeff;
+        powers = mReleasePowers.data();
+    }
+    
+    if (coeff != mEnvelopeCoeff || target != mEnvelopeTarget) {
+        mEnvelopeAnchor = mEnvelopeLevel;
+        mEnvelopeTarget = target;
+        mEnvelopeCoeff = coeff;
+        mEnvelopeSteps = 0;
+        if (powers) mEnvelopeSettle = settleStep(powers, std::fabs(target - mEnvelopeAnchor));
+    }
+    
+    for (int done = 0; done < count; ) {
+        if (powers && mEnvelopeSteps >= mEnvelopeSettle) {
+            mEnvelopeLevel = target;
+            mEnvelopeCoeff = 0.0f;
+            mEnvelopeSteps = 0;
+            powers = nullptr;
+        }
+        // Settled or holding: constant gain
+        if (!powers) {
+            mGateGain = bp.rangeGain + (1.0f - bp.rangeGain) * mEnvelopeLevel;
+            mSimd->fill(gains + done, mGateGain, count - done);
+            return;
+        }
+        const int run = std::min(count - done, std::min(kEnvelopeTableSize, mEnvelopeSettle) - mEnvelopeSteps);
+        mSimd->envelopeGain(gains + done, powers + mEnvelopeSteps + 1,
+                            target, mEnvelopeAnchor, bp.rangeGain, run);
+        mEnvelopeSteps += run;
+        mEnvelopeLevel = target - (target - mEnvelopeAnchor) * powers[mEnvelopeSteps];
+        mGateGain = gains[done + run - 1];
+        done += run;
+        
+        if (mEnvelopeSteps == kEnvelopeTableSize) {
+            mEnvelopeAnchor = mEnvelopeLevel;
+            mEnvelopeSteps = 0;
+            mEnvelopeSettle = settleStep(powers, std::fabs(target - mEnvelopeAnchor));
+        }
+    }
+}
+
+// First step at which a curve starting `distance` from its target is within kEnvelopeSettled
+// of it (the powers only fall); past the table if it does not settle before its restart
+int FrequencyGateDSP::settleStep(const float* powers, float distance)
+{
+    const float* end = powers + kEnvelopeTableSize + 1;
+    return static_cast<int>(std::partition_point(powers, end, [distance](float p) {
+        return distance * p >= kEnvelopeSettled;
+    }) - powers);
+}
+
+// powers[i] = coeff^i, rebuilt only when the coefficient changes (attack / release / sample rate)
+void FrequencyGateDSP::buildPowerTable(std::vector<float>& powers, float& tableCoeff, float coeff)
+{
+    if (coeff == tableCoeff) return;
+    tableCoeff = coeff;
+    double p = 1.0;
+    for (int i = 0; i <= kEnvelopeTableSize; i++) {
+        powers[i] = p > 1e-30 ? static_cast<float>(p) : 0.0f;   // No denormals in the gain loop
+        p *= coeff;
+    }
+}
+
+// Apply the segment's gain curve to every channel (with optional lookahead)
+void FrequencyGateDSP::applyGain(const float** inputs, float** outputs, uint32_t offset, int count)
+{
+    const float* gains = mGainBuffer.data();
+    if (mLookaheadSamples <= 0 || mLookaheadBuffer.empty()) {
+        for (int c = 0; c < mNumChannels; c++)
+            mSimd->applyGain(outputs[c] + offset, inputs[c] + offset, gains, count);
+        return;
+    }
+    
+    for (int c = 0; c < mNumChannels; c++) {
+        const float* in = inputs[c] + offset;
+        float* out = outputs[c] + offset;
+        float* delay = &mLookaheadBuffer[c * mLookaheadSamples];
+        int pos = mLookaheadWritePos;
+        for (int k = 0; k < count; ) {
+            const int run = std::min(count - k, mLookaheadSamples - pos);
+            mSimd->delayApplyGain(out + k, in + k, delay + pos, gains + k, run);
+            k += run;
+            pos = (pos + run) % mLookaheadSamples;
+        }
+    }
+    mLookaheadWritePos = (mLookaheadWritePos + count) % mLookaheadSamples;
+}
+
+void FrequencyGateDSP::prepareBlock(BlockParams& bp) const
+{
+    // Envelope coefficients
+    bp.attackCoeff = std::exp(-1.0f / (static_cast<float>(mSampleRate) * fAttack / 1000.0f));
+    bp.releaseCoeff = std::exp(-1.0f / (static_cast<float>(mSampleRate) * fRelease / 1000.0f));
+    bp.holdSamples = static_cast<int>(fHold * mSampleRate / 1000.0f);
+    bp.rangeGain = dbToLinear(fRange);
+    bp.maskAttackCoeff = std::pow(bp.attackCoeff, static_cast<float>(mHopSize));
+    bp.maskReleaseCoeff = std::pow(bp.releaseCoeff, static_cast<float>(mHopSize));
+    bp.spectral = isSpectralMode();
+    
+    // Detection key. An unconnected sidechain arrives as null or silent buffers; both read as
+    // silence, and once a full analysis window is silent the FFT and detection are skipped.
+    bp.sidechainKey = static_cast<int>(fKeySource) == kKeySidechain;
+    // Per-channel detection needs the key rings of the last reinit; until a pending switch
+    // from Mix is applied the block keeps the mix
+    bp.perChannel = isPerChannelDetect() && !mKeyBuffers.empty();
+    
+    // Followers and injected levels do not analyze, so they skip the key as well
+    bp.follower = mShareRole == kShareFollower;
+    bp.leader = mShareRole == kShareLeader;
+    bp.skipKey = bp.follower || mInjectedLevels != nullptr;
+}
+
+void FrequencyGateDSP::process(const float** inputs, float** outputs, uint32_t frames)
+{
+    const uint64_t blockStart = GateStats::now();
+    applyPendingChanges();
+    updateShareRole(frames);
+    if (mEvents) logParameterChanges();
+    
+    BlockParams bp;
+    prepareBlock(bp);
+    if (bp.follower) mShareHopsLeft = (mHopCounter + static_cast<int>(frames)) / mHopSize;
+    buildPowerTable(mAttackPowers, mAttackPowersCoeff, bp.attackCoeff);
+    buildPowerTable(mReleasePowers, mReleasePowersCoeff, bp.releaseCoeff);
+    
+    // Work in segments that end at the next hop boundary, so every per-sample stage is a
+    // contiguous pass over at most one hop and the gain curve is computed once for all channels
+    for (uint32_t offset = 0; offset < frames; ) {
+        const int count = std::min(mHopSize - mHopCounter, static_cast<int>(frames - offset));
+        const bool hopDue = mHopCounter + count >= mHopSize;
+        
+        if (!bp.skipKey) writeKey(inputs, bp, offset, count);
+        if (bp.spectral) {
+            writeChannels(inputs, offset, count);
+            readSpectralOutput(outputs, offset, count);
+        }
+        mInputWritePos = (mInputWritePos + count) % mCurrentFFTSize;
+        mHopCounter += count;
+        mShareWarmup = std::max(0, mShareWarmup - count);
+        mSampleClock += count;   // Hop events are stamped with the first sample after the hop
+        
+        if (bp.spectral) {
+            if (hopDue) processHop(bp);
+        } else {
+            // The hop's last sample already follows the new decision
+            float* gains = mGainBuffer.data();
+            renderGain(bp, gains, hopDue ? count - 1 : count);
+            if (hopDue) {
+                processHop(bp);
+                renderGain(bp, gains + count - 1, 1);
+            }
+            applyGain(inputs, outputs, offset, count);
+        }
+        offset += count;
+    }
+    mStats.addBlock(blockStart, frames);
+}
+
+// Offline analysis pass: buffers the key and records one detection level per hop, without
+// touching the gate, noise floor or outputs. Levels depend only on the last FFT frame, so a
+// long file can be analyzed in hop-aligned chunks, each preceded by one frame of warm-up.
+uint32_t FrequencyGateDSP::analyze(const float** inputs, uint32_t frames, float* levels)
+{
+    applyPendingChanges();
+    
+    BlockParams bp;
+    prepareBlock(bp);
+    
+    uint32_t hops = 0;
+    for (uint32_t offset = 0; offset < frames; ) {
+        const int count = std::min(mHopSize - mHopCounter, static_cast<int>(frames - offset));
+        writeKey(inputs, bp, offset, count);
+        if (bp.spectral) writeChannels(inputs, offset, count);
+        mInputWritePos = (mInputWritePos + count) % mCurrentFFTSize;
+        mHopCounter += count;
+        offset += count;
+        
+        if (mHopCounter >= mHopSize) {
+            mHopCounter = 0;
+            const float level = measureHopLevel(bp);
+            if (levels) levels[hops] = level;
+            hops++;
+        }
+    }
+    return hops;
+}
+
+// Offline apply pass: process() with the detection levels taken from analyze() instead of
+// the FFT. Only valid when canSplitAnalysis(); returns the number of levels consumed.
+uint32_t FrequencyGateDSP::processWithLevels(const float** inputs, float** outputs, uint32_t frames,
+                                             const float* levels)
+{
+    mInjectedLevels = levels;
+    mInjectedCount = 0;
+    process(inputs, outputs, frames);
+    mInjectedLevels = nullptr;
+    return mInjectedCount;
+}
@@ -0,0 +1,283 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * DSP engine
+ *
+ * Host-independent gate: the plugin wraps it, and the offline tools link it directly.
+ * Parameters use the indices from DistrhoPluginInfo.h; the channel count is chosen at
+ * construction (1..MAX_CHANNELS). process() takes the main channels followed by the
+ * stereo sidechain pair, which may be null.
+ */
+
+#ifndef FREQUENCY_GATE_DSP_HPP_INCLUDED
+#define FREQUENCY_GATE_DSP_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+#include "FrequencyGateNoiseFloor.hpp"
+#include "FrequencyGateSharedBus.hpp"
+#include "FrequencyGateEventLog.hpp"
+#include "FrequencyGateStats.hpp"
+#include "FrequencyGateSimd.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef USE_PFFFT
+extern "C" {
+#include "pffft.h"
+}
+#endif
+
+class FrequencyGateDSP
+{
+public:
+    explicit FrequencyGateDSP(int numChannels, FrequencyGateSimd::Level simd = FrequencyGateSimd::kAuto);
+    ~FrequencyGateDSP();
+
+    int getNumChannels() const { return mNumChannels; }
+    double getSampleRate() const { return mSampleRate; }
+    void setSampleRate(double newSampleRate);
+
+    float getParameter(uint32_t index) const;
+    void setParameter(uint32_t index, float value);
+
+    void activate();
+    void deactivate();
+    void process(const float** inputs, float** outputs, uint32_t frames);
+
+    uint32_t getLatency() const;
+    int getFFTSize() const { return mCurrentFFTSize; }
+    int getHopSize() const { return mHopSize; }
+    bool isGateOpen() const { return mGateOpen; }   // Gate decision after the last hop
+    const char* getSimdName() const { return mSimd->name; }   // Instruction set of the FFT and kernels
+    const GateStats& getStats() const { return mStats; }
+    GateStats& getStats() { return mStats; }
+    void setEventRing(GateEventRing* ring) { mEvents = ring; }   // Optional; set while inactive
+    void setHopPhase(float phase) { mHopPhase = phase; }         // Fraction of a hop (0..1); set while inactive
+    float getHopPhase() const { return mHopPhase; }
+
+    // Offline processing in two passes (see analyze() / processWithLevels())
+    bool canSplitAnalysis() const;
+    uint32_t analyze(const float** inputs, uint32_t frames, float* levels);
+    uint32_t processWithLevels(const float** inputs, float** outputs, uint32_t frames, const float* levels);
+
+private:
+    // Parameters
+    float fFreqLow;          // Detection range low frequency (Hz)
+    float fFreqHigh;         // Detection range high frequency (Hz)
+    float fThreshold;        // Gate threshold (dB)
+    float fDetectionMethod;  // Detection algorithm
+    float fPreOpen;          // Lookahead (ms)
+    float fAttack;           // Attack time (ms)
+    float fHold;             // Hold time (ms)
+    float fRelease;          // Release time (ms)
+    float fHysteresis;       // Hysteresis (dB)
+    float fRange;            // Gate attenuation (dB)
+    float fFFTSizeOption;    // FFT size selection
+    float fGateMode;         // Broadband or spectral gating
+    float fAutoThreshold;    // Auto Threshold on/off
+    float fAutoMargin;       // Auto Threshold margin (dB)
+    float fNoiseFloor;       // Output: tracked noise floor (dB)
+    float fShareGroup;       // Shared analysis group (0 = off)
+    float fKeySource;        // Main or sidechain key
+    float fAveraging;        // Band magnitude averaging across hops (ms, 0 = off)
+    float fChannelDetect;    // Weighted mix or per-channel detection
+    float fChannelWeight[MAX_CHANNELS];  // Detection mix weight per main channel
+
+    // Internal state
+    const int mNumChannels;
+    double mSampleRate;
+    int mCurrentFFTSize;
+    int mHopSize;
+    bool mNeedsReinit;
+    bool mNeedsBandUpdate;       // Freq Low/High changed: recompute the bins at the next block
+    bool mNeedsLookaheadResize;  // Pre-Open changed: resize the delay lines at the next block
+    int mBufferCapacity;         // FFT size the buffers are allocated for (see prepareBuffers())
+    
+    // FFT setup (PFFFT): one per size option at the current sample rate, built off the audio thread
+#ifdef USE_PFFFT
+    PFFFT_Setup* mPffftSetup;            // Setup of the current size (owned by mSetups)
+    PFFFT_Setup* mSetups[kFFTSizeCount];
+    PFFFT_Setup* mPairSetup;             // Complex setup of the current size (owned by mPairSetups)
+    PFFFT_Setup* mPairSetups[kFFTSizeCount];   // Per-channel detection: two channels per transform
+    int mSetupSizes[kFFTSizeCount];
+#endif
+    float* mFftInput;
+    float* mFftOutput;
+    float* mWorkBuffer;
+    float* mSpectra;         // Spectral mode: per-channel spectra (channels x N)
+    const float* mSpectrumPtrs[MAX_CHANNELS];
+    
+    // Window function
+    std::vector<float> mWindow;
+    std::vector<float> mWindowSum;
+    float mWindowGain;  // Amplitude correction factor for window
+    float mOlaGain;     // Overlap-add normalization (analysis * synthesis window)
+    
+    // Circular buffers (doubled for easy access)
+    std::vector<float> mInputBuffer;     // Detection key: weighted channel mix or mono sidechain
+    std::vector<float> mKeyBuffers;      // Per-channel detection: each key channel (key channels x 2N)
+    std::vector<float> mChannelBuffers;  // Spectral mode: per-channel input (channels x 2N)
+    std::vector<float> mOutputBuffers;   // Spectral mode: overlap-add accumulators (channels x N)
+    int mKeySilentSamples;               // Consecutive all-zero key samples (capped at the FFT size)
+    
+    // Per-segment scratch (a segment never crosses a hop boundary)
+    std::vector<float> mMixBuffer;       // Detection key samples
+    std::vector<float> mGainBuffer;      // Gate gain per sample, applied to every channel
+    
+    // Lookahead delay lines (channels x mLookaheadSamples)
+    std::vector<float> mLookaheadBuffer;
+    int mLookaheadWritePos;
+    int mLookaheadSamples;
+    
+    // Buffer positions
+    int mInputWritePos;
+    int mOutputReadPos;
+    int mHopCounter;
+    float mHopPhase;         // First hop comes this fraction of a hop early (see FrequencyGateHopPhase.hpp)
+    
+    // Gate envelope state
+    float mEnvelopeLevel;      // Current envelope (0.0 to 1.0)
+    float mGateGain;           // Current gate gain (linear)
+    bool mGateOpen;            // Gate state for hysteresis
+    int mHoldCounter;          // Hold timer (samples)
+    
+    // Closed-form envelope: env = target - (target - anchor) * coeff^steps
+    std::vector<float> mAttackPowers;    // attackCoeff^i, i = 0..table size
+    std::vector<float> mReleasePowers;
+    float mAttackPowersCoeff;            // Coefficient each table was built for
+    float mReleasePowersCoeff;
+    float mEnvelopeAnchor;               // Envelope where the current curve started
+    float mEnvelopeTarget;
+    float mEnvelopeCoeff;                // Coefficient of the current curve (0 = settled or holding)
+    int mEnvelopeSteps;                  // Samples rendered since the anchor
+    int mEnvelopeSettle;                 // Step at which the curve is within kEnvelopeSettled of its target
+    
+    // Noise floor tracking (Auto Threshold)
+    NoiseFloorTracker mFloorTracker;
+    int mFloorWarmupHops;      // Hops to skip until the analysis buffer has been filled once
+    
+    // Shared analysis bus
+    enum ShareRole { kShareNone = 0, kShareLeader, kShareFollower };
+    int mShareGroup;           // Group currently joined (0 = none)
+    ShareRole mShareRole;
+    uint32_t mShareSeq;        // Last decision sequence published (leader) or applied (follower)
+    uint32_t mShareSeenSeq;    // Last sequence seen at block start, for staleness
+    int mShareStaleSamples;    // Samples since the leader last published
+    int mShareWarmup;          // New leader: samples until its analysis buffer is filled
+    int mShareHopsLeft;        // Follower: hop boundaries left in the current block
+    
+    // Frequency bin cache
+    int mStartBin;
+    int mEndBin;
+    
+    // Temporary buffer for detection
+    std::vector<float> mMagnitudes;
+    std::vector<float> mSortBuffer;      // Median / trimmed mean scratch
+    
+    // Band magnitudes averaged across hops (Averaging); restarted from the next hop's
+    // magnitudes when the band, FFT size or key continuity changes
+    std::vector<float> mAvgMagnitudes;
+    bool mAverageReset;
+    
+    // Spectral mode gain mask
+    std::vector<float> mBinPower;
+    
+    // Per-channel detection: band power of the current channel pair, combined into mBandPower
+    std::vector<float> mChannelPower;    // 2 x bins
+    std::vector<float> mBandPower;
+    std::vector<float> mMaskGain;
+    
+    // Offline apply pass: detection levels supplied by analyze()
+    const float* mInjectedLevels;
+    uint32_t mInjectedCount;
+    
+    // Hot-path counters (written here, read by the plugin and the tools)
+    GateStats mStats;
+    
+    // Event log (optional): input samples since activation, and the parameter values last logged
+    GateEventRing* mEvents;
+    uint64_t mSampleClock;
+    float mLoggedParams[kParamChannelWeight0 + MAX_CHANNELS];
+    
+    // FFT and kernel build for this CPU, chosen once at construction (setups belong to it)
+    const FrequencyGateSimd::Backend* mSimd;
+    
+    // Per-block constants for the segment helpers
+    struct BlockParams {
+        float attackCoeff;
+        float releaseCoeff;
+        float rangeGain;
+        float maskAttackCoeff;   // Spectral mask smoothing runs once per hop
+        float maskReleaseCoeff;
+        int holdSamples;
+        bool spectral;
+        bool sidechainKey;
+        bool perChannel;         // Channel Detect other than Mix
+        bool follower;
+        bool leader;
+        bool skipKey;
+    };
+    
+    // Helper functions
+    void initFFT();
+    void freeFFT();
+    void prepareSetups();
+    void freeSetups();
+    void reinitFFT();
+    void prepareBuffers();
+    void applyPendingChanges();
+    void createWindow();
+    void computeBandBins();
+    float detectLevel();
+    float measureBandLevel();
+    float detectBandLevel(int binCount);
+    float analyzeSpectralHop(bool sidechainKey, bool perChannel, bool keySilent);
+    float analyzeChannelsHop(bool sidechainKey, bool useSpectra);
+    void synthesizeSpectralHop(float thresholdDb, float rangeGain, float attackCoeff, float releaseCoeff);
+    void writeRing(float* ring, const float* src, int count) const;
+    void writeKey(const float** inputs, const BlockParams& bp, uint32_t offset, int count);
+    void writeChannelKeys(const float** inputs, const BlockParams& bp, uint32_t offset, int count);
+    void writeChannels(const float** inputs, uint32_t offset, int count);
+    void readSpectralOutput(float** outputs, uint32_t offset, int count);
+    void prepareBlock(BlockParams& bp) const;
+    float measureHopLevel(const BlockParams& bp);
+    void processHop(const BlockParams& bp);
+    void renderGain(const BlockParams& bp, float* gains, int count);
+    static void buildPowerTable(std::vector<float>& powers, float& tableCoeff, float coeff);
+    static int settleStep(const float* powers, float distance);
+    void applyGain(const float** inputs, float** outputs, uint32_t offset, int count);
+    void resizeLookahead();
+    int lookaheadSamples() const;
+    bool isSpectralMode() const { return static_cast<int>(fGateMode) == kGateSpectral; }
+    bool isPerChannelDetect() const { return static_cast<int>(fChannelDetect) != kChannelMix; }
+    float getOpenThreshold() const;
+    void updateShareRole(uint32_t frames);
+    void leaveShareGroup();
+    void applySharedDecision();
+    void logParameterChanges();
+    void logEvent(uint16_t type, float value, uint16_t param = 0)
+    {
+        if (mEvents) mEvents->push({ mSampleClock, type, param, value });
+    }
+    void publishSharedDecision(float level, bool measured = true);
+    float computeAverage(const std::vector<float>& mags, int start, int count);
+    float computePeak(const std::vector<float>& mags, int start, int count);
+    float computeMedian(std::vector<float>& mags, int start, int count);
+    float computeRMS(const std::vector<float>& mags, int start, int count);
+    float computeTrimmedMean(std::vector<float>& mags, int start, int count);
+    float computeFlatness(const std::vector<float>& mags, int start, int count);
+    float computeHarmonicity(const std::vector<float>& mags, int start, int count);
+    static float voicingWeight(float voicing);
+    static float linearToDb(float linear);
+    static float dbToLinear(float db);
+    
+    // Aligned memory allocation
+    static void* alignedAlloc(size_t size);
+    static void alignedFree(void* ptr);
+
+    FrequencyGateDSP(const FrequencyGateDSP&) = delete;
+    FrequencyGateDSP& operator=(const FrequencyGateDSP&) = delete;
+};
+
+#endif // FREQUENCY_GATE_DSP_HPP_INCLUDED
@@ -0,0 +1,1188 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Streaming gate service
+ *
+ * Gates raw PCM streams without a plugin host. Clients connect to a Unix domain
+ * socket, send one header line followed by interleaved PCM, and read the gated PCM
+ * back on the same connection. With --stdio a single stream goes from stdin to stdout.
+ * Every stream owns one FrequencyGateDSP. Its blocks are processed on a fixed
+ * work-stealing worker pool, and I/O buffers come from a preallocated pool, so
+ * the steady state does not allocate. Client sockets are non-blocking: workers queue
+ * the gated blocks and the I/O thread writes them as the socket drains, so a slow
+ * reader never holds a worker.
+ *
+ * Protocol (one line, then raw PCM until the client shuts down its write side):
+ *   client: format=s16|f32 channels=<n> rate=<hz> [<parameter>=<value> ...]\n
+ *   server: OK latency=<frames>\n    or    ERR <message>\n
+ * The reply is the input delayed by <latency> frames, plus <latency> frames of tail,
+ * so it is exactly <latency> frames longer than the input.
+ */
+
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGateAudioFile.hpp"
+#include "FrequencyGatePresets.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const size_t kBufferBytes = 16384;     // One I/O block (~85 ms of 48 kHz stereo s16)
+static const int kStreamQueueDepth = 32;      // Blocks in flight per stream before reads pause
+static const int kBlocksPerTurn = 4;          // Blocks a worker runs before requeueing a busy stream
+static const double kWriteTimeoutSeconds = 10.0;   // A client that reads nothing for this long is dropped
+static const size_t kHeaderMax = 1024;
+static const size_t kMaxFrameBytes = MAX_CHANNELS * 4;
+
+static std::atomic<bool> gStopRequested{false};
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Handshake replies only: they are the first bytes on the socket, so they fit its buffer
+static bool writeAll(int fd, const uint8_t* data, size_t bytes)
+{
+    while (bytes > 0) {
+        const ssize_t n = ::write(fd, data, bytes);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool parseFormat(const std::string& text, AudioFile::SampleFormat& format)
+{
+    if (text == "s16") format = AudioFile::kSampleS16;
+    else if (text == "f32") format = AudioFile::kSampleF32;
+    else return false;
+    return true;
+}
+
+// ============================================================================
+// Buffer pool
+// ============================================================================
+
+struct Buffer {
+    Buffer* next = nullptr;
+    size_t bytes = 0;
+    Clock::time_point received;
+    uint8_t data[kBufferBytes];
+};
+
+// Preallocated free list; only grows (and counts it) when every buffer is in flight
+class BufferPool
+{
+public:
+    explicit BufferPool(int count)
+    {
+        mOwned.reserve(static_cast<size_t>(count) * 2);
+        for (int i = 0; i < count; i++) {
+            mOwned.emplace_back(new Buffer());
+            release(mOwned.back().get());
+        }
+    }
+
+    Buffer* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mFree) {
+            mOwned.emplace_back(new Buffer());
+            mGrowth++;
+            return mOwned.back().get();
+        }
+        Buffer* buffer = mFree;
+        mFree = buffer->next;
+        return buffer;
+    }
+
+    void release(Buffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        buffer->next = mFree;
+        mFree = buffer;
+    }
+
+    uint64_t growth()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mGrowth;
+    }
+
+private:
+    std::mutex mMutex;
+    Buffer* mFree = nullptr;
+    std::vector<std::unique_ptr<Buffer>> mOwned;
+    uint64_t mGrowth = 0;
+};
+
+// ============================================================================
+// Stream
+// ============================================================================
+
+struct Stream {
+    int id = 0;
+    int inFd = -1;
+    int outFd = -1;
+    bool ownsFds = true;
+
+    // Set up once the header has been parsed
+    bool configured = false;
+    AudioFile::Layout layout;
+    std::unique_ptr<FrequencyGateDSP> dsp;
+    uint32_t latency = 0;
+    uint32_t maxFrames = 0;
+    std::vector<float> planar;
+    std::vector<float*> channels;      // Main channels followed by the unconnected sidechain pair
+
+    // I/O thread only
+    std::string header;
+    uint8_t carry[kMaxFrameBytes];
+    size_t carryBytes = 0;
+
+    // Shared between the I/O thread and the worker holding the stream
+    std::mutex mutex;
+    Buffer* queue[kStreamQueueDepth];
+    int queueHead = 0;
+    int queueCount = 0;
+    bool eof = false;
+    bool scheduled = false;
+    bool finished = false;
+    Buffer* outHead = nullptr;         // Gated blocks waiting for the socket, oldest first
+    Buffer* outTail = nullptr;
+    int outCount = 0;
+    std::atomic<bool> writeFailed{false};   // Set under the mutex; queued output is dropped
+
+    // I/O thread only: progress on the head of the output queue
+    size_t outOffset = 0;
+    bool outPending = false;
+    Clock::time_point outProgress;
+
+    // Written by the worker holding the stream
+    std::atomic<uint64_t> framesOut{0};
+    uint64_t blocks = 0;
+    double turnaroundSum = 0.0;
+    double turnaroundMax = 0.0;
+    Clock::time_point opened = Clock::now();
+};
+
+// ============================================================================
+// Work-stealing worker pool
+// ============================================================================
+
+// One bounded deque per worker. A stream sits in at most one deque at a time (its
+// `scheduled` flag), so a capacity of maxStreams can never overflow. Owners take the
+// oldest stream; idle workers steal the newest one from a busy neighbour.
+class WorkStealingPool
+{
+public:
+    typedef void (*RunFunction)(void* context, Stream* stream);
+
+    WorkStealingPool(int threads, int capacity, RunFunction run, void* context)
+        : mRun(run), mContext(context), mWorkers(threads)
+    {
+        for (Worker& worker : mWorkers) worker.ring.assign(static_cast<size_t>(capacity), nullptr);
+        for (int t = 0; t < threads; t++) mWorkers[t].thread = std::thread([this, t] { work(t); });
+    }
+
+    ~WorkStealingPool() { stop(); }
+
+    void schedule(Stream* stream)
+    {
+        const int count = static_cast<int>(mWorkers.size());
+        const int home = static_cast<int>(mNext.fetch_add(1, std::memory_order_relaxed) % count);
+        for (int k = 0; k < count; k++) {
+            if (push(mWorkers[(home + k) % count], stream)) break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mQueued++;
+        }
+        mWake.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            if (mStopping) return;
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (Worker& worker : mWorkers)
+            if (worker.thread.joinable()) worker.thread.join();
+    }
+
+    int size() const { return static_cast<int>(mWorkers.size()); }
+    double busySeconds(int t) const { return mWorkers[t].busyNs.load(std::memory_order_relaxed) * 1e-9; }
+    uint64_t steals(int t) const { return mWorkers[t].steals.load(std::memory_order_relaxed); }
+    uint64_t tasks(int t) const { return mWorkers[t].tasks.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::vector<Stream*> ring;
+        size_t head = 0;
+        size_t count = 0;
+        std::thread thread;
+        std::atomic<uint64_t> busyNs{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> tasks{0};
+    };
+
+    static bool push(Worker& worker, Stream* stream)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.count == worker.ring.size()) return false;
+        worker.ring[(worker.head + worker.count) % worker.ring.size()] = stream;
+        worker.count++;
+        return true;
+    }
+
+    static Stream* popOldest(Worker& worker)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.count == 0) return nullptr;
+        Stream* stream = worker.ring[worker.head];
+        worker.head = (worker.head + 1) % worker.ring.size();
+        worker.count--;
+        return stream;
+    }
+
+    static Stream* popNewest(Worker& worker)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.count == 0) return nullptr;
+        worker.count--;
+        return worker.ring[(worker.head + worker.count) % worker.ring.size()];
+    }
+
+    Stream* take(int index)
+    {
+        if (Stream* stream = popOldest(mWorkers[index])) return stream;
+        const int count = static_cast<int>(mWorkers.size());
+        for (int k = 1; k < count; k++) {
+            if (Stream* stream = popNewest(mWorkers[(index + k) % count])) {
+                mWorkers[index].steals.fetch_add(1, std::memory_order_relaxed);
+                return stream;
+            }
+        }
+        return nullptr;
+    }
+
+    void work(int index)
+    {
+        Worker& self = mWorkers[index];
+        for (;;) {
+            Stream* stream = take(index);
+            if (!stream) {
+                std::unique_lock<std::mutex> lock(mSleepMutex);
+                mWake.wait(lock, [this] { return mQueued > 0 || mStopping; });
+                if (mQueued == 0 && mStopping) return;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mSleepMutex);
+                mQueued--;
+            }
+            const auto start = Clock::now();
+            mRun(mContext, stream);
+            self.busyNs.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()),
+                std::memory_order_relaxed);
+            self.tasks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    RunFunction mRun;
+    void* mContext;
+    std::vector<Worker> mWorkers;
+    std::atomic<uint64_t> mNext{0};
+    std::mutex mSleepMutex;
+    std::condition_variable mWake;
+    int mQueued = 0;
+    bool mStopping = false;
+};
+
+// ============================================================================
+// Daemon
+// ============================================================================
+
+struct DaemonOptions {
+    std::string socketPath;
+    bool stdio = false;
+    int jobs = 0;
+    int maxStreams = 256;
+    int buffers = 512;
+    double statsInterval = 0.0;        // 0 = only on exit
+    bool verbose = false;
+    // Stream defaults (the stdio stream uses them as its format)
+    AudioFile::SampleFormat format = AudioFile::kSampleS16;
+    int channels = 2;
+    double sampleRate = 48000.0;
+    FrequencyGatePresets::ParamList params;
+};
+
+class Daemon
+{
+public:
+    explicit Daemon(const DaemonOptions& opt)
+        : mOpt(opt),
+          mBuffers(opt.buffers),
+          mPool(opt.jobs, opt.maxStreams, &Daemon::runStream, this)
+    {
+        if (::pipe(mWakePipe) == 0) {
+            for (int fd : mWakePipe) ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+        mStreams.reserve(static_cast<size_t>(opt.maxStreams));
+        mPollFds.reserve(static_cast<size_t>(opt.maxStreams) * 2 + 2);   // Read and write per stream
+        mPollStreams.reserve(static_cast<size_t>(opt.maxStreams) * 2);
+        mClosed.reserve(static_cast<size_t>(opt.maxStreams));
+    }
+
+    ~Daemon()
+    {
+        mPool.stop();
+        if (mListenFd >= 0) ::close(mListenFd);
+        for (int fd : mWakePipe) if (fd >= 0) ::close(fd);
+    }
+
+    bool listen(const std::string& path, std::string& error)
+    {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) { error = "socket path too long"; return false; }
+        std::strcpy(addr.sun_path, path.c_str());
+        ::unlink(path.c_str());
+        mListenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (mListenFd < 0 || ::bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::listen(mListenFd, 64) != 0) {
+            error = "cannot listen on " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        mSocketPath = path;
+        return true;
+    }
+
+    // Single stream from stdin to stdout, formatted by the command-line defaults
+    bool addStdioStream(std::string& error)
+    {
+        Stream* stream = newStream(STDIN_FILENO, STDOUT_FILENO, false);
+        std::ostringstream header;
+        header << "format=" << (mOpt.format == AudioFile::kSampleF32 ? "f32" : "s16")
+               << " channels=" << mOpt.channels << " rate=" << mOpt.sampleRate;
+        if (!configure(*stream, header.str(), error)) return false;
+        mStdio = true;
+        return true;
+    }
+
+    // I/O loop: accepts clients, reads their PCM and writes the gated blocks back until
+    // stopped (or the stdio stream ends)
+    void run()
+    {
+        mStarted = Clock::now();
+        Clock::time_point nextStats = mStarted + statsPeriod();
+        bool stopping = false;
+        while (!mStreams.empty() || !stopping) {
+            if (!stopping && (gStopRequested.load() || mStopRequested.load() || (mStdio && mStreams.empty()))) {
+                stopping = true;
+                if (mListenFd >= 0) { ::close(mListenFd); mListenFd = -1; }
+                for (Stream* stream : mStreams) if (!stream->eof) markEof(*stream);
+                continue;
+            }
+
+            mPollFds.clear();
+            mPollStreams.clear();
+            mPollFds.push_back({ mWakePipe[0], POLLIN, 0 });
+            const bool accepting = mListenFd >= 0 && static_cast<int>(mStreams.size()) < mOpt.maxStreams;
+            if (accepting) mPollFds.push_back({ mListenFd, POLLIN, 0 });
+            const size_t firstStream = mPollFds.size();
+            for (Stream* stream : mStreams) {
+                if (stream->eof) continue;
+                {
+                    // Backpressure: blocks not yet processed or not yet written both count
+                    std::lock_guard<std::mutex> lock(stream->mutex);
+                    if (stream->queueCount + stream->outCount >= kStreamQueueDepth) continue;
+                }
+                mPollFds.push_back({ stream->inFd, POLLIN, 0 });
+                mPollStreams.push_back(stream);
+            }
+            const size_t firstWrite = mPollFds.size();
+            for (Stream* stream : mStreams) {
+                if (!watchOutput(*stream)) continue;
+                mPollFds.push_back({ stream->outFd, POLLOUT, 0 });
+                mPollStreams.push_back(stream);
+            }
+
+            ::poll(mPollFds.data(), mPollFds.size(), 250);
+
+            if (mPollFds[0].revents) {
+                uint8_t drain[64];
+                while (::read(mWakePipe[0], drain, sizeof(drain)) > 0) {}
+            }
+            // Write first: a closed stream is only reaped once its output is out
+            for (size_t i = firstWrite; i < mPollFds.size(); i++) {
+                if (mPollFds[i].revents) writeStream(*mPollStreams[i - firstStream]);
+            }
+            reapClosed();
+            if (accepting && mPollFds[1].revents) acceptClient();
+            for (size_t i = firstStream; i < firstWrite; i++) {
+                if (mPollFds[i].revents) readStream(*mPollStreams[i - firstStream]);
+            }
+
+            if (mOpt.statsInterval > 0.0 && Clock::now() >= nextStats) {
+                printStats(stderr);
+                nextStats += statsPeriod();
+            }
+        }
+        if (!mSocketPath.empty()) ::unlink(mSocketPath.c_str());
+    }
+
+    void requestStop()
+    {
+        mStopRequested = true;
+        wake();
+    }
+
+    // Aggregate throughput: streams-per-core is realtime audio processed per second of worker time
+    void printStats(FILE* out)
+    {
+        const double wall = secondsSince(mStarted);
+        double audio = mClosedAudioSeconds;
+        for (Stream* stream : mStreams)
+            if (stream->configured) audio += stream->framesOut.load(std::memory_order_relaxed) / stream->layout.sampleRate;
+        double busy = 0.0;
+        uint64_t steals = 0;
+        for (int t = 0; t < mPool.size(); t++) {
+            busy += mPool.busySeconds(t);
+            steals += mPool.steals(t);
+        }
+        std::fprintf(out, "frequencygate-daemon: %zu active, %llu served | %.1f s audio in %.1f s | "
+                          "%d workers busy %.2f s, %.1f streams per core | %llu steals | buffer pool growth %llu\n",
+                     mStreams.size(), static_cast<unsigned long long>(mServed), audio, wall,
+                     mPool.size(), busy, busy > 0.0 ? audio / busy : 0.0,
+                     static_cast<unsigned long long>(steals), static_cast<unsigned long long>(mBuffers.growth()));
+        if (mOpt.verbose) {
+            for (int t = 0; t < mPool.size(); t++)
+                std::fprintf(out, "  worker %d: busy %.2f s, %llu tasks, %llu steals\n", t, mPool.busySeconds(t),
+                             static_cast<unsigned long long>(mPool.tasks(t)), static_cast<unsigned long long>(mPool.steals(t)));
+        }
+    }
+
+private:
+    Clock::duration statsPeriod() const
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(mOpt.statsInterval > 0.0 ? mOpt.statsInterval : 1.0));
+    }
+
+    void wake()
+    {
+        const uint8_t byte = 1;
+        if (mWakePipe[1] >= 0) (void)::write(mWakePipe[1], &byte, 1);
+    }
+
+    Stream* newStream(int inFd, int outFd, bool ownsFds)
+    {
+        Stream* stream = new Stream();
+        stream->id = ++mNextId;
+        stream->inFd = inFd;
+        stream->outFd = outFd;
+        stream->ownsFds = ownsFds;
+        mStreams.push_back(stream);
+        return stream;
+    }
+
+    void acceptClient()
+    {
+        const int fd = ::accept(mListenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        newStream(fd, fd, true);
+    }
+
+    bool configure(Stream& stream, const std::string& header, std::string& error)
+    {
+        AudioFile::SampleFormat format = mOpt.format;
+        int channels = mOpt.channels;
+        double sampleRate = mOpt.sampleRate;
+        FrequencyGatePresets::ParamList params = mOpt.params;
+
+        std::istringstream fields(header);
+        std::string field;
+        while (fields >> field) {
+            const size_t eq = field.find('=');
+            const std::string key = field.substr(0, eq);
+            const std::string value = eq == std::string::npos ? std::string() : field.substr(eq + 1);
+            float number = 0.0f;
+            std::pair<uint32_t, float> param;
+            if (key == "format") {
+                if (!parseFormat(value, format)) { error = "format must be s16 or f32"; return false; }
+            } else if (key == "channels") {
+                channels = std::atoi(value.c_str());
+            } else if (key == "rate") {
+                sampleRate = std::atof(value.c_str());
+            } else if (FrequencyGatePresets::parseValue(value, number) && FrequencyGatePresets::resolve(key, number, param)) {
+                params.push_back(param);
+            } else {
+                error = "unknown field " + field;
+                return false;
+            }
+        }
+        if (channels < 1 || channels > MAX_CHANNELS || sampleRate < 8000.0 || sampleRate > 384000.0) {
+            error = "need 1-16 channels and a sample rate of 8-384 kHz";
+            return false;
+        }
+
+        stream.layout.channels = channels;
+        stream.layout.sampleRate = sampleRate;
+        stream.layout.format = format;
+        stream.layout.dataOffset = 0;
+        stream.dsp.reset(new FrequencyGateDSP(channels));
+        stream.dsp->setSampleRate(sampleRate);
+        for (const auto& p : params) stream.dsp->setParameter(p.first, p.second);
+        stream.dsp->activate();
+        stream.latency = stream.dsp->getLatency();
+        stream.maxFrames = static_cast<uint32_t>(kBufferBytes / stream.layout.bytesPerFrame());
+        stream.planar.assign(static_cast<size_t>(channels) * stream.maxFrames, 0.0f);
+        stream.channels.assign(static_cast<size_t>(channels) + 2, nullptr);
+        for (int c = 0; c < channels; c++) stream.channels[c] = &stream.planar[static_cast<size_t>(c) * stream.maxFrames];
+        stream.configured = true;
+        return true;
+    }
+
+    void readStream(Stream& stream)
+    {
+        if (!stream.configured) {
+            readHeader(stream);
+            return;
+        }
+        Buffer* buffer = mBuffers.acquire();
+        std::memcpy(buffer->data, stream.carry, stream.carryBytes);
+        const ssize_t n = ::read(stream.inFd, buffer->data + stream.carryBytes, kBufferBytes - stream.carryBytes);
+        if (n <= 0) {
+            mBuffers.release(buffer);
+            if (n == 0 || (errno != EINTR && errno != EAGAIN)) markEof(stream);
+            return;
+        }
+        submit(stream, buffer, stream.carryBytes + static_cast<size_t>(n));
+    }
+
+    void readHeader(Stream& stream)
+    {
+        char bytes[kHeaderMax];
+        const ssize_t n = ::read(stream.inFd, bytes, kHeaderMax - stream.header.size());
+        if (n <= 0) {
+            if (n == 0 || (errno != EINTR && errno != EAGAIN)) markEof(stream);
+            return;
+        }
+        stream.header.append(bytes, static_cast<size_t>(n));
+        const size_t newline = stream.header.find('\n');
+        if (newline == std::string::npos) {
+            if (stream.header.size() >= kHeaderMax) reject(stream, "header line too long");
+            return;
+        }
+
+        std::string error;
+        if (!configure(stream, stream.header.substr(0, newline), error)) {
+            reject(stream, error);
+            return;
+        }
+        const std::string reply = "OK latency=" + std::to_string(stream.latency) + "\n";
+        if (!writeAll(stream.outFd, reinterpret_cast<const uint8_t*>(reply.data()), reply.size())) {
+            markEof(stream);
+            return;
+        }
+        if (mOpt.verbose)
+            std::fprintf(stderr, "stream %d: %dch %s @ %.0f Hz, latency %u frames\n", stream.id, stream.layout.channels,
+                         stream.layout.format == AudioFile::kSampleF32 ? "f32" : "s16", stream.layout.sampleRate, stream.latency);
+
+        // PCM that arrived in the same read as the header
+        const size_t rest = stream.header.size() - newline - 1;
+        if (rest > 0) {
+            Buffer* buffer = mBuffers.acquire();
+            std::memcpy(buffer->data, stream.header.data() + newline + 1, rest);
+            submit(stream, buffer, rest);
+        }
+        std::string().swap(stream.header);
+    }
+
+    void reject(Stream& stream, const std::string& error)
+    {
+        const std::string reply = "ERR " + error + "\n";
+        writeAll(stream.outFd, reinterpret_cast<const uint8_t*>(reply.data()), reply.size());
+        std::fprintf(stderr, "stream %d rejected: %s\n", stream.id, error.c_str());
+        failWrite(stream);
+    }
+
+    // Stop writing to a client that is gone (or stalled): drop its queued output and stop
+    // reading, so the stream closes once its workers are done
+    void failWrite(Stream& stream)
+    {
+        Buffer* buffer;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            stream.writeFailed = true;
+            buffer = stream.outHead;
+            stream.outHead = stream.outTail = nullptr;
+            stream.outCount = 0;
+        }
+        while (buffer) {
+            Buffer* next = buffer->next;
+            mBuffers.release(buffer);
+            buffer = next;
+        }
+        stream.outOffset = 0;
+        if (!stream.eof) markEof(stream);
+    }
+
+    // I/O thread: true if the stream has output to write. A client that takes nothing for
+    // kWriteTimeoutSeconds is dropped, so it cannot hold its buffers or the shutdown.
+    bool watchOutput(Stream& stream)
+    {
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            pending = stream.outCount > 0;
+        }
+        if (!pending) {
+            stream.outPending = false;
+            return false;
+        }
+        if (!stream.outPending) {
+            stream.outPending = true;
+            stream.outProgress = Clock::now();
+        } else if (secondsSince(stream.outProgress) > kWriteTimeoutSeconds) {
+            std::fprintf(stderr, "stream %d: client stopped reading\n", stream.id);
+            failWrite(stream);
+            return false;
+        }
+        return true;
+    }
+
+    // I/O thread: write queued blocks until the socket is full
+    void writeStream(Stream& stream)
+    {
+        for (;;) {
+            Buffer* buffer;
+            {
+                std::lock_guard<std::mutex> lock(stream.mutex);
+                buffer = stream.outHead;
+            }
+            if (!buffer) return;
+            const ssize_t n = ::write(stream.outFd, buffer->data + stream.outOffset, buffer->bytes - stream.outOffset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (n <= 0) {
+                failWrite(stream);
+                return;
+            }
+            stream.outOffset += static_cast<size_t>(n);
+            stream.outProgress = Clock::now();
+            if (stream.outOffset < buffer->bytes) continue;
+            stream.outOffset = 0;
+            {
+                std::lock_guard<std::mutex> lock(stream.mutex);
+                stream.outHead = buffer->next;
+                if (!stream.outHead) stream.outTail = nullptr;
+                stream.outCount--;
+            }
+            mBuffers.release(buffer);
+        }
+    }
+
+    // Queue the whole frames in `buffer`; a trailing partial frame waits for the next read
+    void submit(Stream& stream, Buffer* buffer, size_t bytes)
+    {
+        const size_t frameBytes = stream.layout.bytesPerFrame();
+        const size_t whole = bytes / frameBytes * frameBytes;
+        stream.carryBytes = bytes - whole;
+        std::memcpy(stream.carry, buffer->data + whole, stream.carryBytes);
+        if (whole == 0) {
+            mBuffers.release(buffer);
+            return;
+        }
+        buffer->bytes = whole;
+        buffer->received = Clock::now();
+
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.queue[(stream.queueHead + stream.queueCount) % kStreamQueueDepth] = buffer;
+        stream.queueCount++;
+        if (!stream.scheduled) {
+            stream.scheduled = true;
+            mPool.schedule(&stream);
+        }
+    }
+
+    void markEof(Stream& stream)
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.eof = true;
+        if (!stream.scheduled) {
+            stream.scheduled = true;
+            mPool.schedule(&stream);
+        }
+    }
+
+    static void runStream(void* context, Stream* stream)
+    {
+        static_cast<Daemon*>(context)->processStream(*stream);
+    }
+
+    // Worker: run a few queued blocks, then requeue the stream so busy streams share workers.
+    // After EOF, flush the latency tail and hand the stream back to the I/O thread.
+    void processStream(Stream& stream)
+    {
+        bool closing = false;
+        for (int turn = 0; ; turn++) {
+            Buffer* buffer = nullptr;
+            bool wasFull = false;
+            {
+                std::lock_guard<std::mutex> lock(stream.mutex);
+                if (stream.queueCount == 0) {
+                    stream.scheduled = false;
+                    closing = stream.eof && !stream.finished;
+                    if (closing) stream.finished = true;
+                    break;
+                }
+                if (turn == kBlocksPerTurn) {
+                    mPool.schedule(&stream);   // Still scheduled; it just goes to the back
+                    return;
+                }
+                wasFull = stream.queueCount == kStreamQueueDepth;
+                buffer = stream.queue[stream.queueHead];
+                stream.queueHead = (stream.queueHead + 1) % kStreamQueueDepth;
+                stream.queueCount--;
+            }
+            if (wasFull) wake();
+            processBuffer(stream, buffer, static_cast<uint32_t>(buffer->bytes / stream.layout.bytesPerFrame()), true);
+        }
+        if (!closing) return;
+
+        if (stream.configured && !stream.writeFailed) {
+            for (uint32_t left = stream.latency; left > 0; ) {
+                const uint32_t frames = std::min(left, stream.maxFrames);
+                Buffer* buffer = mBuffers.acquire();
+                buffer->received = Clock::now();
+                processBuffer(stream, buffer, frames, false);
+                left -= frames;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mClosedMutex);
+            mClosed.push_back(&stream);
+        }
+        wake();
+    }
+
+    void processBuffer(Stream& stream, Buffer* buffer, uint32_t frames, bool hasInput)
+    {
+        AudioFile::Layout block = stream.layout;
+        block.frames = hasInput ? frames : 0;   // No input: decode silence (latency tail)
+        AudioFile::readFrames(buffer->data, block, 0, frames, stream.channels.data());
+        stream.dsp->process(const_cast<const float**>(stream.channels.data()), stream.channels.data(), frames);
+        AudioFile::writeFrames(buffer->data, block, 0, frames, stream.channels.data());
+
+        const double turnaround = secondsSince(buffer->received);
+        buffer->bytes = frames * block.bytesPerFrame();
+        buffer->next = nullptr;
+        bool queued = false, first = false;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            if (!stream.writeFailed) {
+                if (stream.outTail) stream.outTail->next = buffer;
+                else stream.outHead = buffer;
+                stream.outTail = buffer;
+                first = stream.outCount++ == 0;
+                queued = true;
+            }
+        }
+        if (!queued) mBuffers.release(buffer);
+        if (first) wake();   // The I/O thread polls for POLLOUT from now on
+
+        stream.blocks++;
+        stream.turnaroundSum += turnaround;
+        stream.turnaroundMax = std::max(stream.turnaroundMax, turnaround);
+        if (hasInput) stream.framesOut.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    // I/O thread: close finished streams once their output is written, and report their latency
+    void reapClosed()
+    {
+        std::lock_guard<std::mutex> lock(mClosedMutex);
+        size_t kept = 0;
+        for (Stream* stream : mClosed) {
+            {
+                std::lock_guard<std::mutex> streamLock(stream->mutex);
+                if (stream->outCount > 0) {
+                    mClosed[kept++] = stream;
+                    continue;
+                }
+            }
+            if (stream->configured) {
+                const double audio = stream->framesOut.load() / stream->layout.sampleRate;
+                mClosedAudioSeconds += audio;
+                mServed++;
+                std::fprintf(stderr, "stream %d closed: %.1f s audio in %.1f s, latency %.2f ms algorithmic + "
+                                     "%.2f ms mean / %.2f ms max per block%s\n",
+                             stream->id, audio, secondsSince(stream->opened),
+                             stream->latency * 1000.0 / stream->layout.sampleRate,
+                             stream->blocks ? stream->turnaroundSum * 1000.0 / stream->blocks : 0.0,
+                             stream->turnaroundMax * 1000.0, stream->writeFailed ? " (client gone)" : "");
+                if (mOpt.verbose) {
+                    char label[32];
+                    std::snprintf(label, sizeof(label), "stream %d engine", stream->id);
+                    printGateStats(stderr, label, stream->dsp->getStats().snapshot(), stream->layout.sampleRate);
+                }
+            }
+            if (stream->ownsFds) ::close(stream->inFd);
+            for (size_t i = 0; i < mStreams.size(); i++) {
+                if (mStreams[i] == stream) {
+                    mStreams[i] = mStreams.back();
+                    mStreams.pop_back();
+                    break;
+                }
+            }
+            delete stream;
+        }
+        mClosed.resize(kept);
+    }
+
+    const DaemonOptions& mOpt;
+    BufferPool mBuffers;
+    WorkStealingPool mPool;
+    int mListenFd = -1;
+    int mWakePipe[2] = { -1, -1 };
+    std::string mSocketPath;
+    bool mStdio = false;
+    std::atomic<bool> mStopRequested{false};
+    Clock::time_point mStarted = Clock::now();
+
+    std::vector<Stream*> mStreams;     // I/O thread only
+    std::vector<pollfd> mPollFds;
+    std::vector<Stream*> mPollStreams;
+    int mNextId = 0;
+    uint64_t mServed = 0;
+    double mClosedAudioSeconds = 0.0;
+
+    std::mutex mClosedMutex;
+    std::vector<Stream*> mClosed;
+};
+
+// ============================================================================
+// Loopback client
+// ============================================================================
+
+struct ClientOptions {
+    int streams = 4;
+    double seconds = 10.0;
+    bool realtime = false;
+    AudioFile::SampleFormat format = AudioFile::kSampleS16;
+    int channels = 2;
+    double sampleRate = 48000.0;
+    FrequencyGatePresets::ParamList params;
+};
+
+struct ClientResult {
+    bool ok = false;
+    std::string error;
+    uint32_t latency = 0;
+    double meanMs = 0.0;
+    double maxMs = 0.0;
+};
+
+// Test signal: noise floor with 1 kHz bursts, different per stream and channel
+static std::vector<float> makeSignal(const ClientOptions& opt, int index, uint64_t frames)
+{
+    std::vector<float> signal(frames * opt.channels);
+    std::mt19937 rng(1234u + static_cast<unsigned>(index));
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+    const double burstRate = 0.2 + 0.05 * index;
+    for (uint64_t i = 0; i < frames; i++) {
+        const double t = i / opt.sampleRate;
+        const float tone = std::sin(2.0 * M_PI * burstRate * t) > 0.3 ? 0.4f * static_cast<float>(std::sin(2.0 * M_PI * 1000.0 * t)) : 0.0f;
+        for (int c = 0; c < opt.channels; c++) signal[i * opt.channels + c] = tone * (1.0f - 0.1f * c) + noise(rng);
+    }
+    return signal;
+}
+
+static ClientResult runClient(const std::string& path, const ClientOptions& opt, int index)
+{
+    ClientResult result;
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        result.error = "cannot connect to " + path;
+        if (fd >= 0) ::close(fd);
+        return result;
+    }
+
+    AudioFile::Layout layout;
+    layout.channels = opt.channels;
+    layout.sampleRate = opt.sampleRate;
+    layout.format = opt.format;
+    const size_t frameBytes = layout.bytesPerFrame();
+
+    std::ostringstream header;
+    header << "format=" << (opt.format == AudioFile::kSampleF32 ? "f32" : "s16") << " channels=" << opt.channels
+           << " rate=" << opt.sampleRate;
+    for (const auto& p : opt.params) {
+        for (const auto& spec : FrequencyGatePresets::kParamSpecs)
+            if (spec.index == p.first) header << " " << spec.symbol << "=" << p.second;
+        if (p.first >= kParamChannelWeight0) header << " detect_weight_" << (p.first - kParamChannelWeight0 + 1) << "=" << p.second;
+    }
+    header << "\n";
+    const std::string headerText = header.str();
+    writeAll(fd, reinterpret_cast<const uint8_t*>(headerText.data()), headerText.size());
+
+    std::string reply;
+    char ch;
+    while (::read(fd, &ch, 1) == 1 && ch != '\n') reply += ch;
+    if (reply.compare(0, 11, "OK latency=") != 0) {
+        result.error = reply.empty() ? "no reply" : reply;
+        ::close(fd);
+        return result;
+    }
+    result.latency = static_cast<uint32_t>(std::atoi(reply.c_str() + 11));
+
+    // Encode the whole input up front, then send it in 10 ms packets
+    const uint64_t frames = static_cast<uint64_t>(opt.seconds * opt.sampleRate);
+    const std::vector<float> signal = makeSignal(opt, index, frames);
+    std::vector<uint8_t> input(frames * frameBytes);
+    {
+        std::vector<float> planar(frames * opt.channels);
+        std::vector<float*> ptrs(opt.channels);
+        for (int c = 0; c < opt.channels; c++) {
+            ptrs[c] = &planar[c * frames];
+            for (uint64_t i = 0; i < frames; i++) ptrs[c][i] = signal[i * opt.channels + c];
+        }
+        layout.frames = frames;
+        AudioFile::writeFrames(input.data(), layout, 0, static_cast<uint32_t>(frames), ptrs.data());
+    }
+    const uint32_t packetFrames = static_cast<uint32_t>(opt.sampleRate / 100.0);
+    const uint64_t packets = (frames + packetFrames - 1) / packetFrames;
+    std::vector<std::atomic<int64_t>> sentAt(packets);
+
+    const auto start = Clock::now();
+    std::thread sender([&] {
+        for (uint64_t k = 0; k < packets; k++) {
+            const uint64_t first = k * packetFrames;
+            const uint64_t count = std::min<uint64_t>(packetFrames, frames - first);
+            if (opt.realtime) std::this_thread::sleep_until(start + std::chrono::duration<double>(first / opt.sampleRate));
+            sentAt[k].store(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            if (!writeAll(fd, &input[first * frameBytes], count * frameBytes)) break;
+        }
+        ::shutdown(fd, SHUT_WR);
+    });
+
+    // Packet k is back once the output covers its last frame (plus the algorithmic latency)
+    const uint64_t expectedBytes = (frames + result.latency) * frameBytes;
+    std::vector<uint8_t> output;
+    output.reserve(expectedBytes);
+    uint8_t chunk[65536];
+    uint64_t nextPacket = 0;
+    double latencySum = 0.0;
+    for (;;) {
+        const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) break;
+        output.insert(output.end(), chunk, chunk + n);
+        const double now = std::chrono::duration<double>(Clock::now() - start).count();
+        while (nextPacket < packets) {
+            const uint64_t end = std::min<uint64_t>((nextPacket + 1) * packetFrames, frames) + result.latency;
+            if (output.size() < end * frameBytes) break;
+            const double ms = (now - sentAt[nextPacket].load() * 1e-9) * 1000.0;
+            latencySum += ms;
+            result.maxMs = std::max(result.maxMs, ms);
+            nextPacket++;
+        }
+    }
+    sender.join();
+    ::close(fd);
+    result.meanMs = nextPacket ? latencySum / nextPacket : 0.0;
+
+    if (output.size() != expectedBytes) {
+        result.error = "received " + std::to_string(output.size()) + " bytes, expected " + std::to_string(expectedBytes);
+        return result;
+    }
+
+    // Reference: the same engine run locally in one block must give identical bytes
+    FrequencyGateDSP dsp(opt.channels);
+    dsp.setSampleRate(opt.sampleRate);
+    for (const auto& p : opt.params) dsp.setParameter(p.first, p.second);
+    dsp.activate();
+    const uint64_t total = frames + result.latency;
+    std::vector<float> planar(total * opt.channels, 0.0f);
+    std::vector<float*> ptrs(opt.channels + 2, nullptr);
+    for (int c = 0; c < opt.channels; c++) ptrs[c] = &planar[c * total];
+    layout.frames = frames;
+    AudioFile::readFrames(input.data(), layout, 0, static_cast<uint32_t>(total), ptrs.data());
+    dsp.process(const_cast<const float**>(ptrs.data()), ptrs.data(), static_cast<uint32_t>(total));
+    std::vector<uint8_t> expected(expectedBytes);
+    layout.frames = total;
+    AudioFile::writeFrames(expected.data(), layout, 0, static_cast<uint32_t>(total), ptrs.data());
+    if (expected != output) {
+        result.error = "output differs from the offline reference";
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
+
+static int runClients(const std::string& path, const ClientOptions& opt)
+{
+    std::vector<ClientResult> results(opt.streams);
+    std::vector<std::thread> threads;
+    for (int k = 0; k < opt.streams; k++)
+        threads.emplace_back([&, k] { results[k] = runClient(path, opt, k); });
+    for (std::thread& thread : threads) thread.join();
+
+    int failures = 0;
+    for (int k = 0; k < opt.streams; k++) {
+        const ClientResult& r = results[k];
+        if (r.ok) std::printf("client %d: ok, latency %u frames, round trip %.2f ms mean / %.2f ms max\n",
+                              k, r.latency, r.meanMs, r.maxMs);
+        else std::printf("client %d: FAILED: %s\n", k, r.error.c_str());
+        failures += r.ok ? 0 : 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void printUsage()
+{
+    std::printf(
+        "Usage: frequencygate-daemon --socket <path> [options]   serve streams on a Unix socket\n"
+        "       frequencygate-daemon --stdio [options]           gate stdin to stdout\n"
+        "       frequencygate-daemon --loopback <n> [options]    self-test with n local clients\n"
+        "       frequencygate-daemon --connect <path> --streams <n> [options]   test clients only\n"
+        "\n"
+        "  -j, --jobs <n>           Worker threads (default: all cores)\n"
+        "      --max-streams <n>    Concurrent streams (default 256)\n"
+        "      --buffers <n>        Preallocated I/O buffers of 16 KiB (default 512)\n"
+        "      --stats <seconds>    Print aggregate throughput periodically\n"
+        "      --format <s16|f32>   Sample format for --stdio and test clients (default s16)\n"
+        "      --channels <n>       Channels for --stdio and test clients (default 2)\n"
+        "      --rate <hz>          Sample rate for --stdio and test clients (default 48000)\n"
+        "      --seconds <s>        Test client stream length (default 10)\n"
+        "      --realtime           Test clients send at the real-time rate\n"
+        "      --preset <file>      Default parameters for every stream\n"
+        "      --<parameter> <v>    Default parameter, e.g. --threshold -35\n"
+        "  -v, --verbose            Per-stream and per-worker details (with engine counters)\n");
+}
+
+static void onSignal(int) { gStopRequested = true; }
+
+int main(int argc, char** argv)
+{
+    DaemonOptions opt;
+    ClientOptions client;
+    std::string connectPath;
+    int loopback = 0;
+    std::string error;
+    FrequencyGatePresets::ParamList cliParams;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+        else if (arg == "-v" || arg == "--verbose") opt.verbose = true;
+        else if (arg == "--stdio") opt.stdio = true;
+        else if (arg == "--realtime") client.realtime = true;
+        else if (!hasValue) { error = "missing value for " + arg; break; }
+        else if (arg == "--socket") opt.socketPath = argv[++i];
+        else if (arg == "--connect") connectPath = argv[++i];
+        else if (arg == "--loopback") loopback = std::atoi(argv[++i]);
+        else if (arg == "--streams") client.streams = std::atoi(argv[++i]);
+        else if (arg == "--seconds") client.seconds = std::atof(argv[++i]);
+        else if (arg == "-j" || arg == "--jobs") opt.jobs = std::atoi(argv[++i]);
+        else if (arg == "--max-streams") opt.maxStreams = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--buffers") opt.buffers = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--stats") opt.statsInterval = std::atof(argv[++i]);
+        else if (arg == "--channels") opt.channels = std::atoi(argv[++i]);
+        else if (arg == "--rate") opt.sampleRate = std::atof(argv[++i]);
+        else if (arg == "--format") { if (!parseFormat(argv[++i], opt.format)) { error = "--format expects s16 or f32"; break; } }
+        else if (arg == "--preset") { if (!FrequencyGatePresets::loadPreset(argv[++i], opt.params, error)) break; }
+        else if (arg.compare(0, 2, "--") == 0) {
+            float value;
+            std::pair<uint32_t, float> param;
+            if (!FrequencyGatePresets::parseValue(argv[++i], value) || !FrequencyGatePresets::resolve(arg.substr(2), value, param)) {
+                error = "unknown option or bad value: " + arg;
+                break;
+            }
+            cliParams.push_back(param);
+        }
+        else { error = "unknown option: " + arg; break; }
+    }
+    opt.params.insert(opt.params.end(), cliParams.begin(), cliParams.end());
+    if (error.empty() && opt.socketPath.empty() && !opt.stdio && loopback <= 0 && connectPath.empty())
+        error = "one of --socket, --stdio, --loopback or --connect is required";
+    if (!error.empty()) {
+        std::fprintf(stderr, "frequencygate-daemon: %s\n\n", error.c_str());
+        printUsage();
+        return 1;
+    }
+    if (opt.jobs <= 0) opt.jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    client.format = opt.format;
+    client.channels = opt.channels;
+    client.sampleRate = opt.sampleRate;
+    client.params = opt.params;
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (!connectPath.empty()) return runClients(connectPath, client);
+
+    Daemon daemon(opt);
+    if (loopback > 0) {
+        const std::string path = "/tmp/frequencygate-" + std::to_string(::getpid()) + ".sock";
+        if (!daemon.listen(path, error)) {
+            std::fprintf(stderr, "frequencygate-daemon: %s\n", error.c_str());
+            return 1;
+        }
+        client.streams = loopback;
+        std::thread server([&] { daemon.run(); });
+        const int status = runClients(path, client);
+        daemon.requestStop();
+        server.join();
+        daemon.printStats(stdout);
+        return status;
+    }
+
+    if (opt.stdio ? !daemon.addStdioStream(error) : !daemon.listen(opt.socketPath, error)) {
+        std::fprintf(stderr, "frequencygate-daemon: %s\n", error.c_str());
+        return 1;
+    }
+    daemon.run();
+    daemon.printStats(stderr);
+    return 0;
+}
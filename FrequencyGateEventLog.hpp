@@ -0,0 +1,250 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Gate event log
+ *
+ * The engine pushes gate transitions, hold expiries and parameter changes into a
+ * preallocated single-producer / single-consumer ring from the audio thread. A
+ * background thread drains the ring to a CSV or compact binary file. A full ring
+ * drops the event and counts it; the audio thread never blocks, allocates or does I/O.
+ *
+ * Timestamps are input sample positions since activation, so an event can be found
+ * in a recording of the gate's input (the output is later by the reported latency).
+ */
+
+#ifndef FREQUENCY_GATE_EVENT_LOG_HPP_INCLUDED
+#define FREQUENCY_GATE_EVENT_LOG_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Lock-free ring for one producer thread and one consumer thread. The capacity is
+// rounded up to a power of two and allocated once, at construction.
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "items are copied with memcpy");
+
+public:
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        mItems.resize(size);
+        mMask = size - 1;
+    }
+
+    // Producer: false (and counted as dropped) when the ring is full
+    bool push(const T& item)
+    {
+        const uint64_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) > mMask) {
+            mDropped.store(mDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        mItems[head & mMask] = item;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: all `count` items, or none (counted as one drop)
+    bool pushAll(const T* items, size_t count)
+    {
+        const uint64_t head = mHead.load(std::memory_order_relaxed);
+        if (mItems.size() - (head - mTail.load(std::memory_order_acquire)) < count) {
+            mDropped.store(mDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        const size_t start = head & mMask;
+        const size_t first = std::min(count, mItems.size() - start);
+        std::memcpy(&mItems[start], items, first * sizeof(T));
+        std::memcpy(&mItems[0], items + first, (count - first) * sizeof(T));
+        mHead.store(head + count, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: free slots; only grows until the producer pushes again
+    size_t space() const
+    {
+        return mItems.size() - (mHead.load(std::memory_order_relaxed) - mTail.load(std::memory_order_acquire));
+    }
+
+    // Consumer: false when the ring is empty
+    bool pop(T& item)
+    {
+        const uint64_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mHead.load(std::memory_order_acquire)) return false;
+        item = mItems[tail & mMask];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: up to `max` items; returns how many
+    size_t popSome(T* items, size_t max)
+    {
+        const uint64_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t count = std::min<uint64_t>(max, mHead.load(std::memory_order_acquire) - tail);
+        const size_t start = tail & mMask;
+        const size_t first = std::min(count, mItems.size() - start);
+        std::memcpy(items, &mItems[start], first * sizeof(T));
+        std::memcpy(items + first, &mItems[0], (count - first) * sizeof(T));
+        mTail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t capacity() const { return mItems.size(); }
+    uint64_t dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> mItems;
+    size_t mMask = 0;
+    alignas(64) std::atomic<uint64_t> mHead{0};      // Written by the producer
+    alignas(64) std::atomic<uint64_t> mTail{0};      // Written by the consumer
+    alignas(64) std::atomic<uint64_t> mDropped{0};   // Written by the producer
+};
+
+enum GateEventType : uint16_t {
+    kEventStart = 0,        // Activation: value = sample rate, sample positions restart at 0
+    kEventOpen,             // Gate opened: value = detection level (dB)
+    kEventClose,            // Gate closed: value = detection level (dB)
+    kEventHoldExpired,      // Hold ran out with the gate still open: value = detection level (dB)
+    kEventParameter,        // Parameter changed: param = index, value = new value
+    kEventDropped,          // Written by the drain thread: sample = events dropped so far
+    kEventTypeCount
+};
+
+struct GateEvent {
+    uint64_t sample;        // Input sample position since activation
+    uint16_t type;
+    uint16_t param;
+    float value;
+};
+
+typedef SpscRing<GateEvent> GateEventRing;
+
+// Parameter symbols as exported by the plugin
+inline std::string gateParameterSymbol(uint32_t index)
+{
+    static const char* const kSymbols[] = {
+        "freq_low", "freq_high", "threshold", "detection", "preopen", "attack", "hold", "release",
+        "hysteresis", "range", "fft_size", "gate_mode", "auto_threshold", "auto_margin", "noise_floor",
+        "share_group", "key_source", "dsp_load", "dsp_peak", "averaging",
+        "channel_detect",
+    };
+    static_assert(sizeof(kSymbols) / sizeof(kSymbols[0]) == kParamChannelWeight0, "one symbol per parameter");
+    if (index < static_cast<uint32_t>(kParamChannelWeight0)) return kSymbols[index];
+    return "detect_weight_" + std::to_string(index - kParamChannelWeight0 + 1);
+}
+
+// Owns a ring and the thread that drains it to a file. Files ending in .csv are text;
+// anything else gets 16-byte binary records after an 8-byte "FGEVLOG1" header. Offline
+// callers that outrun any drain interval open without the thread and drain() after each block.
+class GateEventRecorder
+{
+public:
+    static constexpr size_t kRingCapacity = 4096;
+    static constexpr int kDrainIntervalMs = 20;
+
+    GateEventRecorder() : mRing(kRingCapacity) {}
+    ~GateEventRecorder() { close(); }
+
+    bool open(const std::string& path, bool background = true)
+    {
+        close();
+        mFile = std::fopen(path.c_str(), "wb");
+        if (!mFile) return false;
+        mCsv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        if (mCsv) std::fprintf(mFile, "sample,time_s,event,parameter,value\n");
+        else std::fwrite("FGEVLOG1", 1, 8, mFile);
+        mSampleRate = 0.0;
+        mDroppedWritten = 0;
+        mStop = false;
+        if (background) mThread = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Stops the drain thread after writing everything that was pushed before the call
+    void close()
+    {
+        if (mThread.joinable()) {
+            mStop = true;
+            mThread.join();
+        } else if (mFile) {
+            drain();
+        }
+        if (mFile) std::fclose(mFile);
+        mFile = nullptr;
+    }
+
+    bool isOpen() const { return mFile != nullptr; }
+    GateEventRing& ring() { return mRing; }
+
+    // Write out everything queued so far (the drain thread's job when there is one)
+    void drain()
+    {
+        GateEvent event;
+        bool wrote = false;
+        while (mRing.pop(event)) {
+            write(event);
+            wrote = true;
+        }
+        const uint64_t dropped = mRing.dropped();
+        if (dropped != mDroppedWritten) {
+            mDroppedWritten = dropped;
+            write({ dropped, kEventDropped, 0, 0.0f });
+            wrote = true;
+        }
+        if (wrote) std::fflush(mFile);
+    }
+
+private:
+    void run()
+    {
+        for (;;) {
+            const bool stopping = mStop.load();
+            drain();
+            if (stopping) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(kDrainIntervalMs));
+        }
+    }
+
+    void write(const GateEvent& event)
+    {
+        if (event.type == kEventStart) mSampleRate = event.value;
+        if (!mCsv) {
+            std::fwrite(&event, sizeof(event), 1, mFile);
+            return;
+        }
+        static const char* const kNames[kEventTypeCount] = { "start", "open", "close", "hold_expired", "parameter", "dropped" };
+        const char* name = event.type < kEventTypeCount ? kNames[event.type] : "unknown";
+        const double seconds = mSampleRate > 0.0 ? event.sample / mSampleRate : 0.0;
+        if (event.type == kEventDropped)
+            std::fprintf(mFile, ",,dropped,,%llu\n", static_cast<unsigned long long>(event.sample));
+        else if (event.type == kEventParameter)
+            std::fprintf(mFile, "%llu,%.6f,%s,%s,%g\n", static_cast<unsigned long long>(event.sample), seconds, name,
+                         gateParameterSymbol(event.param).c_str(), event.value);
+        else
+            std::fprintf(mFile, "%llu,%.6f,%s,,%g\n", static_cast<unsigned long long>(event.sample), seconds, name, event.value);
+    }
+
+    GateEventRing mRing;
+    std::FILE* mFile = nullptr;
+    bool mCsv = true;
+    double mSampleRate = 0.0;
+    uint64_t mDroppedWritten = 0;
+    std::atomic<bool> mStop{false};
+    std::thread mThread;
+
+    GateEventRecorder(const GateEventRecorder&) = delete;
+    GateEventRecorder& operator=(const GateEventRecorder&) = delete;
+};
+
+#endif // FREQUENCY_GATE_EVENT_LOG_HPP_INCLUDED
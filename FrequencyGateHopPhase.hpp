@@ -0,0 +1,44 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Hop-phase allocator
+ *
+ * Every instance runs its FFT once per hop. If all instances in a session start their
+ * hop at the same sample, they all analyze in the same host callback and the others
+ * do almost nothing, so the callback peak grows with the instance count. Each instance
+ * takes a hop phase from this process-wide sequence instead, so the FFTs are spread
+ * over the callbacks of a hop.
+ *
+ * The sequence is the base-2 van der Corput sequence (0, 1/2, 1/4, 3/4, 1/8, ...): any
+ * 2^k consecutive instances land in 2^k different 1/2^k slices of the hop, however many
+ * instances there are and whatever the ratio of hop size to host buffer.
+ */
+
+#ifndef FREQUENCY_GATE_HOP_PHASE_HPP_INCLUDED
+#define FREQUENCY_GATE_HOP_PHASE_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+
+namespace HopPhase {
+
+// Bit-reversed index as a fraction of a hop in [0, 1)
+inline float fromIndex(uint32_t index)
+{
+    index = (index << 16) | (index >> 16);
+    index = ((index & 0x00FF00FFu) << 8) | ((index & 0xFF00FF00u) >> 8);
+    index = ((index & 0x0F0F0F0Fu) << 4) | ((index & 0xF0F0F0F0u) >> 4);
+    index = ((index & 0x33333333u) << 2) | ((index & 0xCCCCCCCCu) >> 2);
+    index = ((index & 0x55555555u) << 1) | ((index & 0xAAAAAAAAu) >> 1);
+    return static_cast<float>((index >> 8) * (1.0 / 16777216.0));   // 24 bits: exact in a float
+}
+
+// Next phase in the process; thread-safe, called once per instance
+inline float allocate()
+{
+    static std::atomic<uint32_t> next{0};
+    return fromIndex(next.fetch_add(1, std::memory_order_relaxed));
+}
+
+} // namespace HopPhase
+
+#endif // FREQUENCY_GATE_HOP_PHASE_HPP_INCLUDED
@@ -0,0 +1,275 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Headless JACK client
+ *
+ * Runs the gate as a JACK client with no UI and no plugin host, for servers without a
+ * display. Parameters come from the command line or a preset file, as in the other tools.
+ * Start-up does only what the audio callback needs: the engine builds its FFT setups and
+ * buffers for JACK's sample rate before the client is activated, so the first callback
+ * processes audio right away. The time to each start-up stage is reported.
+ */
+
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGatePresets.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <jack/jack.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<bool> gStopRequested{false};
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct JackOptions {
+    std::string clientName = "FrequencyGate";
+    std::string serverName;
+    int channels = 2;
+    bool sidechain = false;                 // Register a stereo sidechain and key from it
+    bool connect = false;                   // Connect to the first physical ports
+    bool verbose = false;
+    FrequencyGatePresets::ParamList params;
+};
+
+class JackGate
+{
+public:
+    JackGate(const JackOptions& opt) : mOpt(opt) {}
+
+    ~JackGate() { if (mClient) jack_client_close(mClient); }
+
+    bool open(Clock::time_point launch, std::string& error)
+    {
+        jack_status_t status;
+        const jack_options_t options = mOpt.serverName.empty() ? JackNoStartServer
+                                                                : static_cast<jack_options_t>(JackNoStartServer | JackServerName);
+        mClient = jack_client_open(mOpt.clientName.c_str(), options, &status, mOpt.serverName.c_str());
+        if (!mClient) {
+            error = "cannot connect to the JACK server";
+            return false;
+        }
+        mConnectedMs = msSince(launch);
+
+        // Engine first: every FFT setup and buffer exists before the first callback
+        const Clock::time_point engineStart = Clock::now();
+        mDSP.reset(new FrequencyGateDSP(mOpt.channels));
+        mDSP->setSampleRate(jack_get_sample_rate(mClient));
+        for (const auto& param : mOpt.params) mDSP->setParameter(param.first, param.second);
+        if (mOpt.sidechain) mDSP->setParameter(kParamKeySource, kKeySidechain);
+        mDSP->activate();
+        mEngineMs = msSince(engineStart);
+
+        for (int c = 0; c < mOpt.channels; c++) {
+            const std::string in = "in_" + std::to_string(c + 1);
+            const std::string out = "out_" + std::to_string(c + 1);
+            mInputPorts.push_back(jack_port_register(mClient, in.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0));
+            mOutputPorts.push_back(jack_port_register(mClient, out.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0));
+        }
+        if (mOpt.sidechain) {
+            mInputPorts.push_back(jack_port_register(mClient, "sidechain_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0));
+            mInputPorts.push_back(jack_port_register(mClient, "sidechain_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0));
+        }
+        for (jack_port_t* port : mInputPorts) if (!port) { error = "cannot register ports"; return false; }
+        for (jack_port_t* port : mOutputPorts) if (!port) { error = "cannot register ports"; return false; }
+
+        // Buffer pointers for the callback, sized once (main channels + stereo sidechain)
+        mInputs.assign(mOpt.channels + 2, nullptr);
+        mOutputs.assign(mOpt.channels, nullptr);
+
+        jack_set_process_callback(mClient, onProcess, this);
+        jack_set_latency_callback(mClient, onLatency, this);
+        jack_on_shutdown(mClient, onShutdown, this);
+
+        if (jack_activate(mClient) != 0) {
+            error = "cannot activate the JACK client";
+            return false;
+        }
+        mActiveMs = msSince(launch);
+        if (mOpt.connect) connectPhysical();
+        return true;
+    }
+
+    void report() const
+    {
+        std::fprintf(stderr, "%s: %d channel(s)%s at %.0f Hz, %u frames per period, FFT %d (%s), latency %u frames\n",
+                     jack_get_client_name(mClient), mOpt.channels, mOpt.sidechain ? " + sidechain" : "",
+                     mDSP->getSampleRate(), jack_get_buffer_size(mClient), mDSP->getFFTSize(), mDSP->getSimdName(),
+                     mDSP->getLatency());
+        std::fprintf(stderr, "startup: server %.1f ms, engine %.1f ms, active %.1f ms after launch\n",
+                     mConnectedMs, mEngineMs, mActiveMs);
+    }
+
+    // Main thread: wait for the first processed period, then until stopped
+    void run(Clock::time_point launch)
+    {
+        bool firstReported = false;
+        while (!gStopRequested && !mServerGone) {
+            if (!firstReported && mFirstPeriod.load()) {
+                const double ms = std::chrono::duration<double, std::milli>(
+                    Clock::time_point(Clock::duration(mFirstPeriodTime.load())) - launch).count();
+                std::fprintf(stderr, "startup: first period processed %.1f ms after launch\n", ms);
+                firstReported = true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        if (mServerGone) std::fprintf(stderr, "JACK server shut down\n");
+        else jack_deactivate(mClient);
+        if (mOpt.verbose) printGateStats(stderr, "engine", mDSP->getStats().snapshot(), mDSP->getSampleRate());
+    }
+
+private:
+    static int onProcess(jack_nframes_t frames, void* arg)
+    {
+        JackGate* self = static_cast<JackGate*>(arg);
+        const size_t inputs = self->mInputPorts.size();
+        for (size_t p = 0; p < inputs; p++)
+            self->mInputs[p] = static_cast<const float*>(jack_port_get_buffer(self->mInputPorts[p], frames));
+        for (int c = 0; c < self->mOpt.channels; c++)
+            self->mOutputs[c] = static_cast<float*>(jack_port_get_buffer(self->mOutputPorts[c], frames));
+        self->mDSP->process(self->mInputs.data(), self->mOutputs.data(), frames);
+
+        if (!self->mFirstPeriod.load(std::memory_order_relaxed)) {
+            self->mFirstPeriodTime.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            self->mFirstPeriod.store(true, std::memory_order_release);
+        }
+        return 0;
+    }
+
+    // Outputs lag the inputs by the engine's latency (Pre-Open, or one frame in spectral mode)
+    static void onLatency(jack_latency_callback_mode_t mode, void* arg)
+    {
+        JackGate* self = static_cast<JackGate*>(arg);
+        const jack_nframes_t latency = self->mDSP->getLatency();
+        jack_latency_range_t range;
+        if (mode == JackCaptureLatency) {
+            jack_port_get_latency_range(self->mInputPorts[0], mode, &range);
+            range.min += latency;
+            range.max += latency;
+            for (jack_port_t* port : self->mOutputPorts) jack_port_set_latency_range(port, mode, &range);
+        } else {
+            jack_port_get_latency_range(self->mOutputPorts[0], mode, &range);
+            range.min += latency;
+            range.max += latency;
+            for (jack_port_t* port : self->mInputPorts) jack_port_set_latency_range(port, mode, &range);
+        }
+    }
+
+    static void onShutdown(void* arg) { static_cast<JackGate*>(arg)->mServerGone = true; }
+
+    // Inputs from the first capture ports, outputs to the first playback ports
+    void connectPhysical()
+    {
+        const char** capture = jack_get_ports(mClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsOutput);
+        const char** playback = jack_get_ports(mClient, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | JackPortIsInput);
+        for (int c = 0; c < mOpt.channels; c++) {
+            if (capture && capture[c]) jack_connect(mClient, capture[c], jack_port_name(mInputPorts[c]));
+            if (playback && playback[c]) jack_connect(mClient, jack_port_name(mOutputPorts[c]), playback[c]);
+            if ((!capture || !capture[c]) && (!playback || !playback[c])) break;
+        }
+        if (capture) jack_free(capture);
+        if (playback) jack_free(playback);
+    }
+
+    const JackOptions mOpt;
+    jack_client_t* mClient = nullptr;
+    std::unique_ptr<FrequencyGateDSP> mDSP;
+    std::vector<jack_port_t*> mInputPorts;   // Main channels, then the sidechain pair
+    std::vector<jack_port_t*> mOutputPorts;
+    std::vector<const float*> mInputs;
+    std::vector<float*> mOutputs;
+    std::atomic<bool> mFirstPeriod{false};
+    std::atomic<Clock::rep> mFirstPeriodTime{0};
+    std::atomic<bool> mServerGone{false};
+    double mConnectedMs = 0.0;
+    double mEngineMs = 0.0;
+    double mActiveMs = 0.0;
+
+    JackGate(const JackGate&) = delete;
+    JackGate& operator=(const JackGate&) = delete;
+};
+
+static void printUsage()
+{
+    std::printf(
+        "Usage: frequencygate-jack [options]\n"
+        "\n"
+        "  -n, --name <name>        JACK client name (default FrequencyGate)\n"
+        "  -s, --server <name>      JACK server name\n"
+        "      --channels <n>       Main channels (default 2, up to 16)\n"
+        "      --sidechain          Add sidechain_left/right inputs and key the gate from them\n"
+        "  -c, --connect            Connect to the physical capture and playback ports\n"
+        "      --preset <file>      Parameter preset: one '<parameter> = <value>' per line\n"
+        "      --<parameter> <v>    Set a parameter, e.g. --threshold -35 --fft_size 3\n"
+        "  -v, --verbose            Print the engine counters on exit\n"
+        "\n"
+        "Parameters: freq_low freq_high threshold detection preopen attack hold release\n"
+        "            hysteresis range fft_size gate_mode auto_threshold auto_margin averaging\n"
+        "            channel_detect detect_weight_1..16 (values as in the plugin; enums by index)\n");
+}
+
+static void onSignal(int) { gStopRequested = true; }
+
+int main(int argc, char** argv)
+{
+    const Clock::time_point launch = Clock::now();
+    JackOptions opt;
+    std::string error;
+    FrequencyGatePresets::ParamList cliParams;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+        else if (arg == "-v" || arg == "--verbose") opt.verbose = true;
+        else if (arg == "-c" || arg == "--connect") opt.connect = true;
+        else if (arg == "--sidechain") opt.sidechain = true;
+        else if (!hasValue) { error = "missing value for " + arg; break; }
+        else if (arg == "-n" || arg == "--name") opt.clientName = argv[++i];
+        else if (arg == "-s" || arg == "--server") opt.serverName = argv[++i];
+        else if (arg == "--channels") opt.channels = std::atoi(argv[++i]);
+        else if (arg == "--preset") { if (!FrequencyGatePresets::loadPreset(argv[++i], opt.params, error)) break; }
+        else if (arg.compare(0, 2, "--") == 0) {
+            float value;
+            std::pair<uint32_t, float> param;
+            if (!FrequencyGatePresets::parseValue(argv[++i], value) || !FrequencyGatePresets::resolve(arg.substr(2), value, param)) {
+                error = "unknown option or bad value: " + arg;
+                break;
+            }
+            cliParams.push_back(param);
+        }
+        else { error = "unknown option: " + arg; break; }
+    }
+    // Command-line values override the preset regardless of order
+    opt.params.insert(opt.params.end(), cliParams.begin(), cliParams.end());
+    if (error.empty() && (opt.channels < 1 || opt.channels > MAX_CHANNELS)) error = "--channels must be 1-16";
+    if (!error.empty()) {
+        std::fprintf(stderr, "frequencygate-jack: %s\n\n", error.c_str());
+        printUsage();
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    JackGate gate(opt);
+    if (!gate.open(launch, error)) {
+        std::fprintf(stderr, "frequencygate-jack: %s\n", error.c_str());
+        return 1;
+    }
+    gate.report();
+    gate.run(launch);
+    return 0;
+}
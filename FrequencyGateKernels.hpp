@@ -0,0 +1,311 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Vectorizable DSP kernels
+ *
+ * Plain loops over contiguous, aligned buffers with no loop-carried
+ * dependencies and no branches, so the compiler can emit SIMD code for them.
+ *
+ * The kernels listed in FrequencyGateSimd.hpp are also compiled once per instruction set.
+ * They must not call inline library functions (std::min, std::sqrt, ...): those are shared
+ * between translation units, and the linker may keep the copy built for a wider set.
+ */
+
+#ifndef FREQUENCY_GATE_KERNELS_HPP_INCLUDED
+#define FREQUENCY_GATE_KERNELS_HPP_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace FrequencyGateKernels {
+
+// Reductions keep 8 independent partial sums so they vectorize without -ffast-math
+static const int kReduceLanes = 8;
+
+// Sum of n values
+static inline float sum(const float* __restrict x, int n)
+{
+    float acc[kReduceLanes] = {};
+    int i = 0;
+    for (; i + kReduceLanes <= n; i += kReduceLanes)
+        for (int l = 0; l < kReduceLanes; l++) acc[l] += x[i + l];
+    float total = 0.0f;
+    for (; i < n; i++) total += x[i];
+    for (int l = 0; l < kReduceLanes; l++) total += acc[l];
+    return total;
+}
+
+// log2 approximation for positive normal floats (max error ~2e-4): exponent bits plus
+// the atanh series of the mantissa, log2(m) = 2/ln2 * (t + t^3/3 + t^5/5), t = (m-1)/(m+1)
+static inline float fastLog2(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    const float t = (m - 1.0f) / (m + 1.0f);
+    const float t2 = t * t;
+    return exponent + t * (2.8853901f + t2 * (0.96179669f + t2 * 0.57707802f));
+}
+
+// Sum of log2(x[i] + tiny) over n positive values
+static inline float sumLog2(const float* __restrict x, int n)
+{
+    float acc[kReduceLanes] = {};
+    int i = 0;
+    for (; i + kReduceLanes <= n; i += kReduceLanes)
+        for (int l = 0; l < kReduceLanes; l++) acc[l] += fastLog2(x[i + l] + 1e-20f);
+    float total = 0.0f;
+    for (; i < n; i++) total += fastLog2(x[i] + 1e-20f);
+    for (int l = 0; l < kReduceLanes; l++) total += acc[l];
+    return total;
+}
+
+// Square root for the kernels: static like them, so every instruction set keeps its own copy
+static inline float squareRoot(float x)
+{
+#if defined(__GNUC__)
+    return __builtin_sqrtf(x);
+#else
+    return sqrtf(x);   // MSVC expands it as an intrinsic
+#endif
+}
+
+// dst[i] = src[i] * win[i]
+static inline void applyWindow(float* __restrict dst, const float* __restrict src,
+                               const float* __restrict win, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] = src[i] * win[i];
+}
+
+// dst[i] = src[i] * gain
+static inline void scale(float* __restrict dst, const float* __restrict src, float gain, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] = src[i] * gain;
+}
+
+// dst[i] += src[i] * gain
+static inline void accumulate(float* __restrict dst, const float* __restrict src, float gain, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] += src[i] * gain;
+}
+
+// dst = weighted mean of srcs[c] + offset over n samples. Sources with a weight <= 0 are
+// left out; null sources (unconnected ports) count as silence.
+static inline void weightedMean(float* __restrict dst, const float* const* srcs, const float* weights,
+                                int numSrcs, uint32_t offset, int n)
+{
+    float weightSum = 0.0f;
+    bool written = false;
+    for (int c = 0; c < numSrcs; c++) {
+        if (weights[c] <= 0.0f) continue;
+        weightSum += weights[c];
+        if (!srcs[c]) continue;
+        if (written) accumulate(dst, srcs[c] + offset, weights[c], n);
+        else scale(dst, srcs[c] + offset, weights[c], n);
+        written = true;
+    }
+    if (!written) std::memset(dst, 0, n * sizeof(float));
+    else if (weightSum != 1.0f) {
+        const float norm = 1.0f / weightSum;
+        for (int i = 0; i < n; i++) dst[i] *= norm;
+    }
+}
+
+// dst[i] = value
+static inline void fill(float* __restrict dst, float value, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] = value;
+}
+
+// Closed-form one-pole segment: the envelope after i steps from `start` towards `target` is
+// target - (target - start) * c^i, with c^i read from a power table. gain = range + (1 - range) * env.
+static inline void envelopeGain(float* __restrict gain, const float* __restrict powers,
+                                float target, float start, float rangeGain, int n)
+{
+    const float delta = target - start;
+    const float depth = 1.0f - rangeGain;
+    for (int i = 0; i < n; i++) gain[i] = rangeGain + depth * (target - delta * powers[i]);
+}
+
+// Exponential average across hops: avg[i] = x[i] + (avg[i] - x[i]) * coeff, then x[i] = avg[i]
+static inline void averageSpectrum(float* __restrict x, float* __restrict avg, float coeff, int n)
+{
+    for (int i = 0; i < n; i++) {
+        avg[i] = x[i] + (avg[i] - x[i]) * coeff;
+        x[i] = avg[i];
+    }
+}
+
+// Number of trailing zero samples in x[0..n)
+static inline int trailingZeros(const float* x, int n)
+{
+    int i = n;
+    while (i > 0 && x[i - 1] == 0.0f) i--;
+    return n - i;
+}
+
+// out[i] = in[i] * gain[i]. The host may process in place (out == in), which rules
+// out __restrict on the pair, so that case gets its own loop.
+static inline void applyGain(float* out, const float* in, const float* __restrict gain, int n)
+{
+    if (out == in) {
+        float* __restrict io = out;
+        for (int i = 0; i < n; i++) io[i] *= gain[i];
+        return;
+    }
+    float* __restrict dst = out;
+    const float* __restrict src = in;
+    for (int i = 0; i < n; i++) dst[i] = src[i] * gain[i];
+}
+
+// Lookahead: out[i] = delay[i] * gain[i], then delay[i] = in[i] (in-place safe, see applyGain)
+static inline void delayApplyGain(float* out, const float* in, float* __restrict delay,
+                                  const float* __restrict gain, int n)
+{
+    if (out == in) {
+        float* __restrict io = out;
+        for (int i = 0; i < n; i++) {
+            const float x = io[i];
+            io[i] = delay[i] * gain[i];
+            delay[i] = x;
+        }
+        return;
+    }
+    float* __restrict dst = out;
+    const float* __restrict src = in;
+    for (int i = 0; i < n; i++) {
+        dst[i] = delay[i] * gain[i];
+        delay[i] = src[i];
+    }
+}
+
+// Per-bin power |X(k)|^2 of an ordered PFFFT real spectrum for k = 0..N/2
+static inline void binPower(float* __restrict power, const float* __restrict x, int fftSize)
+{
+    const int halfSize = fftSize / 2;
+    for (int k = 1; k < halfSize; k++) power[k] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+    power[0] = x[0] * x[0];
+    power[halfSize] = x[1] * x[1];
+}
+
+// power[k] = max(power[k], |X(k)|^2), linking the per-bin power across channels
+static inline void maxBinPower(float* __restrict power, const float* __restrict x, int fftSize)
+{
+    const int halfSize = fftSize / 2;
+    for (int k = 1; k < halfSize; k++) {
+        const float p = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+        power[k] = p > power[k] ? p : power[k];
+    }
+    const float dc = x[0] * x[0], nyquist = x[1] * x[1];
+    power[0] = dc > power[0] ? dc : power[0];
+    power[halfSize] = nyquist > power[halfSize] ? nyquist : power[halfSize];
+}
+
+// Per-bin power of an ordered PFFFT real spectrum for k = first..first+n-1 (k >= 1, up to N/2)
+static inline void bandPower(float* __restrict power, const float* __restrict x, int fftSize, int first, int n)
+{
+    const int inner = fftSize / 2 - first < n ? fftSize / 2 - first : n;
+    for (int i = 0; i < inner; i++) {
+        const int k = first + i;
+        power[i] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+    }
+    if (inner < n) power[inner] = x[1] * x[1];   // Nyquist
+}
+
+// Two windowed channels as one complex signal z = a + ib (interleaved), so a single complex
+// transform analyzes both; see pairBandPower
+static inline void packPair(float* __restrict z, const float* __restrict a, const float* __restrict b,
+                            const float* __restrict win, int n)
+{
+    for (int i = 0; i < n; i++) {
+        z[2 * i] = a[i] * win[i];
+        z[2 * i + 1] = b[i] * win[i];
+    }
+}
+
+// Split the ordered complex spectrum Z of z = a + ib by conjugate symmetry into the power of
+// A(k) = (Z(k) + conj Z(N-k)) / 2 and B(k) = (Z(k) - conj Z(N-k)) / 2i, for k = first..first+n-1
+// (1 <= k <= N/2). At k = N/2 both terms are the same bin, which yields A = Re Z and B = Im Z.
+// Z(N-k) is first copied into `mirror` (2n floats) in ascending k: the compiler vectorizes a
+// reversed copy of complex pairs, but not the arithmetic on them in one loop.
+static inline void pairBandPower(float* __restrict powerA, float* __restrict powerB, float* __restrict mirror,
+                                 const float* __restrict z, int fftSize, int first, int n)
+{
+    const float* down = z + 2 * (fftSize - first);
+    for (int i = 0; i < n; i++) {
+        mirror[2 * i] = down[-2 * i];
+        mirror[2 * i + 1] = down[-2 * i + 1];
+    }
+    const float* up = z + 2 * first;
+    for (int i = 0; i < n; i++) {
+        const float zr = up[2 * i], zi = up[2 * i + 1];
+        const float mr = mirror[2 * i], mi = mirror[2 * i + 1];
+        const float ar = zr + mr, ai = zi - mi;
+        const float br = zi + mi, bi = mr - zr;
+        powerA[i] = 0.25f * (ar * ar + ai * ai);
+        powerB[i] = 0.25f * (br * br + bi * bi);
+    }
+}
+
+// acc[i] = max(acc[i], power[i] * gain)
+static inline void maxPower(float* __restrict acc, const float* __restrict power, float gain, int n)
+{
+    for (int i = 0; i < n; i++) {
+        const float p = power[i] * gain;
+        acc[i] = p > acc[i] ? p : acc[i];
+    }
+}
+
+// acc[i] += sqrt(power[i]) * gain
+static inline void accumulateMagnitude(float* __restrict acc, const float* __restrict power, float gain, int n)
+{
+    for (int i = 0; i < n; i++) acc[i] += squareRoot(power[i]) * gain;
+}
+
+// dst[i] = sqrt(src[i] * gain)
+static inline void scaledSqrt(float* __restrict dst, const float* __restrict src, float gain, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] = squareRoot(src[i] * gain);
+}
+
+// One-pole smoothing of a per-bin gain mask towards 1 (bin open) or floor (bin closed)
+static inline void smoothMask(float* __restrict mask, const float* __restrict power,
+                              float openPower, bool gateOpen, float floorGain,
+                              float attackCoeff, float releaseCoeff, int count)
+{
+    const float openGain = gateOpen ? 1.0f : floorGain;
+    for (int k = 0; k < count; k++) {
+        const float target = power[k] >= openPower ? openGain : floorGain;
+        const float coeff = target > mask[k] ? attackCoeff : releaseCoeff;
+        mask[k] = target + (mask[k] - target) * coeff;
+    }
+}
+
+// Multiply an ordered PFFFT real spectrum by a per-bin gain mask (k = 0..N/2)
+static inline void applyMask(float* __restrict spectrum, const float* __restrict mask, int fftSize)
+{
+    const int halfSize = fftSize / 2;
+    const float dc = spectrum[0] * mask[0];
+    const float nyquist = spectrum[1] * mask[halfSize];
+    for (int k = 1; k < halfSize; k++) {
+        spectrum[2 * k] *= mask[k];
+        spectrum[2 * k + 1] *= mask[k];
+    }
+    spectrum[0] = dc;
+    spectrum[1] = nyquist;
+}
+
+// dst[i] += src[i] * win[i] * gain
+static inline void overlapAdd(float* __restrict dst, const float* __restrict src,
+                              const float* __restrict win, float gain, int n)
+{
+    for (int i = 0; i < n; i++) dst[i] += src[i] * win[i] * gain;
+}
+
+} // namespace FrequencyGateKernels
+
+#endif // FREQUENCY_GATE_KERNELS_HPP_INCLUDED
@@ -0,0 +1,148 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Memory-mapped file for the offline tools
+ *
+ * Read-only mappings for inputs, and read/write mappings of a new file with a fixed
+ * size for outputs, so workers can decode and encode disjoint regions in parallel.
+ * Writers that do not know the final size resize() as they go.
+ */
+
+#ifndef FREQUENCY_GATE_MAPPED_FILE_HPP_INCLUDED
+#define FREQUENCY_GATE_MAPPED_FILE_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+
+    bool openRead(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mFile, &size)) { close(); return false; }
+        mSize = static_cast<size_t>(size.QuadPart);
+        return map(false);
+#else
+        mFd = ::open(path.c_str(), O_RDONLY);
+        if (mFd < 0) return false;
+        struct stat st;
+        if (fstat(mFd, &st) != 0) { close(); return false; }
+        mSize = static_cast<size_t>(st.st_size);
+        return map(false);
+#endif
+    }
+
+    // Create (or truncate) a file of exactly `size` bytes and map it writable
+    bool create(const std::string& path, size_t size)
+    {
+        close();
+        mSize = size;
+#ifdef _WIN32
+        mFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE) return false;
+        return map(true);
+#else
+        mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mFd < 0) return false;
+        if (ftruncate(mFd, static_cast<off_t>(size)) != 0) { close(); return false; }
+        return map(true);
+#endif
+    }
+
+    // New size for a file opened with create(); the contents up to the smaller size stay,
+    // but the mapping moves, so earlier data() pointers are invalid
+    bool resize(size_t size)
+    {
+#ifdef _WIN32
+        if (mData) UnmapViewOfFile(mData);
+        if (mMapping) CloseHandle(mMapping);
+        mData = nullptr;
+        mMapping = nullptr;
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(mFile, end, nullptr, FILE_BEGIN) || !SetEndOfFile(mFile)) { close(); return false; }
+#else
+        if (mData) munmap(mData, mSize);
+        mData = nullptr;
+        if (ftruncate(mFd, static_cast<off_t>(size)) != 0) { close(); return false; }
+#endif
+        mSize = size;
+        return map(true);
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (mData) UnmapViewOfFile(mData);
+        if (mMapping) CloseHandle(mMapping);
+        if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+        mMapping = nullptr;
+        mFile = INVALID_HANDLE_VALUE;
+#else
+        if (mData) munmap(mData, mSize);
+        if (mFd >= 0) ::close(mFd);
+        mFd = -1;
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    const uint8_t* data() const { return mData; }
+    uint8_t* data() { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    bool map(bool writable)
+    {
+        if (mSize == 0) return true;  // Nothing to map; data() stays null
+#ifdef _WIN32
+        const ULONGLONG size = static_cast<ULONGLONG>(mSize);
+        mMapping = CreateFileMappingA(mFile, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                      static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (!mMapping) { close(); return false; }
+        mData = static_cast<uint8_t*>(MapViewOfFile(mMapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+#else
+        void* ptr = mmap(nullptr, mSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, mFd, 0);
+        mData = (ptr == MAP_FAILED) ? nullptr : static_cast<uint8_t*>(ptr);
+        if (mData && !writable) madvise(mData, mSize, MADV_SEQUENTIAL);
+#endif
+        if (!mData) { close(); return false; }
+        return true;
+    }
+
+#ifdef _WIN32
+    HANDLE mFile = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#else
+    int mFd = -1;
+#endif
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+#endif // FREQUENCY_GATE_MAPPED_FILE_HPP_INCLUDED
@@ -0,0 +1,94 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Noise floor tracker for Auto Threshold
+ *
+ * Minimum statistics over the per-hop detection levels: the levels are lightly
+ * smoothed, then a sliding-window minimum is kept with a monotonic deque. Each hop
+ * pushes one value and pops at most what it pushed over its lifetime, so the cost
+ * is O(1) amortized per hop. All storage is allocated in prepare(), or up front with
+ * reserve() so a later prepare() on the audio thread does not allocate.
+ */
+
+#ifndef FREQUENCY_GATE_NOISE_FLOOR_HPP_INCLUDED
+#define FREQUENCY_GATE_NOISE_FLOOR_HPP_INCLUDED
+
+#include <vector>
+#include <cstdint>
+
+class NoiseFloorTracker
+{
+public:
+    NoiseFloorTracker()
+        : mCapacity(0), mHead(0), mCount(0), mHop(0)
+        , mSmoothCoeff(0.0f), mSmoothed(-96.0f), mFloor(-96.0f), mPrimed(false) {}
+
+    // windowHops: length of the minimum search window; smoothCoeff: per-hop one-pole coefficient
+    void prepare(int windowHops, float smoothCoeff)
+    {
+        mCapacity = windowHops > 1 ? windowHops : 1;
+        mValues.assign(mCapacity, 0.0f);
+        mIndices.assign(mCapacity, 0);
+        mSmoothCoeff = smoothCoeff;
+        reset();
+    }
+
+    // Allocate for windows of up to windowHops, without changing the current window
+    void reserve(int windowHops)
+    {
+        mValues.reserve(windowHops);
+        mIndices.reserve(windowHops);
+    }
+
+    void reset()
+    {
+        mHead = 0;
+        mCount = 0;
+        mHop = 0;
+        mSmoothed = -96.0f;
+        mFloor = -96.0f;
+        mPrimed = false;
+    }
+
+    // Feed one detection level (dB); returns the current floor estimate (dB)
+    float process(float levelDb)
+    {
+        if (mCapacity == 0) return mFloor;
+
+        if (!mPrimed) { mSmoothed = levelDb; mPrimed = true; }
+        else mSmoothed = levelDb + (mSmoothed - levelDb) * mSmoothCoeff;
+
+        // Expire the front once it leaves the window (at most one entry per hop)
+        if (mCount > 0 && mHop - mIndices[mHead] >= static_cast<uint64_t>(mCapacity)) {
+            mHead = (mHead + 1) % mCapacity;
+            mCount--;
+        }
+
+        // Drop candidates that can never be the minimum again
+        while (mCount > 0 && mValues[slot(mCount - 1)] >= mSmoothed) mCount--;
+        mValues[slot(mCount)] = mSmoothed;
+        mIndices[slot(mCount)] = mHop;
+        mCount++;
+
+        mHop++;
+        mFloor = mValues[mHead];
+        return mFloor;
+    }
+
+    float getFloor() const { return mFloor; }
+
+private:
+    int slot(int i) const { return (mHead + i) % mCapacity; }
+
+    std::vector<float> mValues;      // Deque of smoothed levels, increasing from front to back
+    std::vector<uint64_t> mIndices;  // Hop index of each deque entry
+    int mCapacity;
+    int mHead;
+    int mCount;
+    uint64_t mHop;
+    float mSmoothCoeff;
+    float mSmoothed;
+    float mFloor;
+    bool mPrimed;
+};
+
+#endif // FREQUENCY_GATE_NOISE_FLOOR_HPP_INCLUDED
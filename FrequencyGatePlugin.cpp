@@ -1,276 +1,44 @@
 /*
  * FrequencyGate - Frequency-selective noise gate
- * DSP Implementation - Fixed FFT normalization and level detection
+ * Plugin wrapper: parameters, ports and latency reporting around the DSP engine
  */
 
 #include "FrequencyGatePlugin.hpp"
-#include <cstring>
+#include "FrequencyGateHopPhase.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
-#include <algorithm>
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include <ctime>
+#include <string>
 
 START_NAMESPACE_DISTRHO
 
-// Memory helpers
-void* FrequencyGatePlugin::alignedAlloc(size_t size) {
-#ifdef _MSC_VER
-    return _aligned_malloc(size, 64);
-#elif defined(__MINGW32__) || defined(__MINGW64__)
-    return __mingw_aligned_malloc(size, 64);
-#else
-    void* ptr = nullptr;
-    if (posix_memalign(&ptr, 64, size) != 0) return nullptr;
-    return ptr;
-#endif
-}
-
-void FrequencyGatePlugin::alignedFree(void* ptr) {
-    if (!ptr) return;
-#ifdef _MSC_VER
-    _aligned_free(ptr);
-#elif defined(__MINGW32__) || defined(__MINGW64__)
-    __mingw_aligned_free(ptr);
-#else
-    free(ptr);
-#endif
-}
-
-// Constructor
 FrequencyGatePlugin::FrequencyGatePlugin()
     : Plugin(kParamCount, 0, 0)
-    , fFreqLow(100.0f), fFreqHigh(500.0f), fThreshold(-30.0f)
-    , fDetectionMethod(0.0f), fPreOpen(0.0f), fAttack(5.0f)
-    , fHold(50.0f), fRelease(100.0f), fHysteresis(3.0f)
-    , fRange(-96.0f), fFFTSizeOption(2.0f)
-    , mSampleRate(48000.0), mCurrentFFTSize(DEFAULT_FFT_SIZE)
-    , mHopSize(DEFAULT_FFT_SIZE / FFT_OVERLAP), mNeedsReinit(false)
-#ifdef USE_PFFFT
-    , mPffftSetup(nullptr)
-#endif
-    , mFftInput(nullptr), mFftOutput(nullptr), mWorkBuffer(nullptr)
-    , mWindowGain(1.0f), mLookaheadWritePos(0), mLookaheadSamples(0)
-    , mInputWritePos(0), mOutputReadPos(0), mHopCounter(0)
-    , mEnvelopeLevel(0.0f), mGateGain(0.0f), mGateOpen(false)
-    , mHoldCounter(0), mStartBin(0), mEndBin(0)
-{
-}
-
-FrequencyGatePlugin::~FrequencyGatePlugin() { freeFFT(); }
-
-// FFT Management
-void FrequencyGatePlugin::initFFT()
-{
-    freeFFT();
-    mCurrentFFTSize = getFFTSizeFromOption(static_cast<int>(fFFTSizeOption));
-    mHopSize = mCurrentFFTSize / FFT_OVERLAP;
-    
-#ifdef USE_PFFFT
-    mPffftSetup = pffft_new_setup(mCurrentFFTSize, PFFFT_REAL);
-#endif
-    
-    mFftInput = static_cast<float*>(alignedAlloc(mCurrentFFTSize * sizeof(float)));
-    mFftOutput = static_cast<float*>(alignedAlloc(mCurrentFFTSize * sizeof(float)));
-    mWorkBuffer = static_cast<float*>(alignedAlloc(mCurrentFFTSize * sizeof(float)));
-    
-    if (mFftInput) std::memset(mFftInput, 0, mCurrentFFTSize * sizeof(float));
-    if (mFftOutput) std::memset(mFftOutput, 0, mCurrentFFTSize * sizeof(float));
-    if (mWorkBuffer) std::memset(mWorkBuffer, 0, mCurrentFFTSize * sizeof(float));
-    
-    const size_t bufSize = mCurrentFFTSize * 2;
-    mInputBufferL.resize(bufSize, 0.0f);
-    mInputBufferR.resize(bufSize, 0.0f);
-    
-    mWindow.resize(mCurrentFFTSize);
-    mWindowSum.resize(mCurrentFFTSize, 0.0f);
-    createWindow();
-    
-    mMagnitudes.resize(mCurrentFFTSize / 2 + 1, 0.0f);
-    mInputWritePos = 0;
-    mHopCounter = 0;
-    
-    computeBandBins();
-    
-    mLookaheadSamples = static_cast<int>(fPreOpen * mSampleRate / 1000.0);
-    if (mLookaheadSamples > 0) {
-        mLookaheadBufferL.resize(mLookaheadSamples, 0.0f);
-        mLookaheadBufferR.resize(mLookaheadSamples, 0.0f);
-    } else {
-        mLookaheadBufferL.clear();
-        mLookaheadBufferR.clear();
-    }
-    mLookaheadWritePos = 0;
-}
-
-void FrequencyGatePlugin::freeFFT()
-{
-#ifdef USE_PFFFT
-    if (mPffftSetup) { pffft_destroy_setup(mPffftSetup); mPffftSetup = nullptr; }
-#endif
-    alignedFree(mFftInput); mFftInput = nullptr;
-    alignedFree(mFftOutput); mFftOutput = nullptr;
-    alignedFree(mWorkBuffer); mWorkBuffer = nullptr;
-}
-
-void FrequencyGatePlugin::reinitFFT() { initFFT(); mNeedsReinit = false; }
-
-void FrequencyGatePlugin::createWindow()
-{
-    // Hann window
-    const float twoPi = 2.0f * static_cast<float>(M_PI);
-    float sum = 0.0f;
-    for (int i = 0; i < mCurrentFFTSize; i++) {
-        mWindow[i] = 0.5f * (1.0f - std::cos(twoPi * i / (mCurrentFFTSize - 1)));
-        sum += mWindow[i];
-    }
-    // Coherent gain compensation: Hann ~= 0.5, so multiply by ~2
-    mWindowGain = static_cast<float>(mCurrentFFTSize) / sum;
-}
-
-void FrequencyGatePlugin::computeBandBins()
-{
-    const double binWidth = mSampleRate / mCurrentFFTSize;
-    const int nyquistBin = mCurrentFFTSize / 2;
-    const double nyquistFreq = mSampleRate / 2.0;
-    
-    double lowFreq = std::max(20.0, static_cast<double>(fFreqLow));
-    double highFreq = std::min(nyquistFreq, static_cast<double>(fFreqHigh));
-    if (lowFreq >= highFreq) highFreq = lowFreq + binWidth;
-    
-    mStartBin = std::max(1, static_cast<int>(std::floor(lowFreq / binWidth)));
-    mEndBin = std::min(nyquistBin, static_cast<int>(std::ceil(highFreq / binWidth)));
-    if (mEndBin <= mStartBin) mEndBin = mStartBin + 1;
-}
-
-// Level detection
-float FrequencyGatePlugin::linearToDb(float linear)
-{
-    if (linear < 1e-10f) return -96.0f;
-    return std::max(-96.0f, 20.0f * std::log10(linear));
-}
-
-float FrequencyGatePlugin::dbToLinear(float db)
+    , mDSP(kNumChannels)
+    , mReportedLatency(0)
+    , fDspLoad(0.0f)
+    , fDspPeak(0.0f)
 {
-    if (db <= -96.0f) return 0.0f;
-    return std::pow(10.0f, db / 20.0f);
+    mDSP.setSampleRate(getSampleRate());
+    mDSP.setHopPhase(HopPhase::allocate());   // Instances in a session take turns running their FFT
+    if (const char* dir = std::getenv("FREQUENCYGATE_EVENT_LOG")) openEventLog(dir);
+    if (const char* dir = std::getenv("FREQUENCYGATE_CAPTURE")) openCapture(dir);
 }
 
-float FrequencyGatePlugin::detectLevel()
-{
-#ifdef USE_PFFFT
-    if (!mPffftSetup || !mFftInput || !mFftOutput) return -96.0f;
-    
-    pffft_transform_ordered(mPffftSetup, mFftInput, mFftOutput, mWorkBuffer, PFFFT_FORWARD);
-    
-    // PFFFT real FFT output (ordered):
-    // [0] = DC, [1] = Nyquist, [2k] = Re(k), [2k+1] = Im(k) for k=1..N/2-1
-    
-    // Normalization: divide by N, multiply by 2 for single-sided (except DC/Nyquist)
-    // Also apply window gain compensation
-    const int N = mCurrentFFTSize;
-    const int halfSize = N / 2;
-    
-    int binCount = 0;
-    for (int bin = mStartBin; bin <= mEndBin && bin <= halfSize; bin++) {
-        float re, im;
-        
-        if (bin == 0) {
-            re = mFftOutput[0] / N * mWindowGain;
-            im = 0.0f;
-        } else if (bin == halfSize) {
-            re = mFftOutput[1] / N * mWindowGain;
-            im = 0.0f;
-        } else {
-            // Single-sided: multiply by 2
-            re = mFftOutput[bin * 2] * 2.0f / N * mWindowGain;
-            im = mFftOutput[bin * 2 + 1] * 2.0f / N * mWindowGain;
-        }
-        
-        // Magnitude (amplitude)
-        mMagnitudes[bin] = std::sqrt(re * re + im * im);
-        binCount++;
-    }
-    
-    if (binCount == 0) return -96.0f;
-    
-    // Apply detection method on LINEAR magnitudes
-    float level = 0.0f;
-    switch (static_cast<int>(fDetectionMethod)) {
-        case kDetectPeak:
-            level = computePeak(mMagnitudes, mStartBin, binCount);
-            break;
-        case kDetectMedian:
-            level = computeMedian(mMagnitudes, mStartBin, binCount);
-            break;
-        case kDetectRMS:
-            level = computeRMS(mMagnitudes, mStartBin, binCount);
-            break;
-        case kDetectTrimmedMean:
-            level = computeTrimmedMean(mMagnitudes, mStartBin, binCount);
-            break;
-        case kDetectAverage:
-        default:
-            level = computeAverage(mMagnitudes, mStartBin, binCount);
-            break;
-    }
-    
-    // Convert to dBFS
-    return linearToDb(level);
-#else
-    return -96.0f;
-#endif
-}
+FrequencyGatePlugin::~FrequencyGatePlugin() {}
 
-// Detection algorithms
-float FrequencyGatePlugin::computeAverage(const std::vector<float>& mags, int start, int count)
+// Audio ports
+void FrequencyGatePlugin::initAudioPort(bool input, uint32_t index, AudioPort& port)
 {
-    if (count <= 0) return 0.0f;
-    float sum = 0.0f;
-    for (int i = 0; i < count; i++) sum += mags[start + i];
-    return sum / count;
-}
-
-float FrequencyGatePlugin::computePeak(const std::vector<float>& mags, int start, int count)
-{
-    if (count <= 0) return 0.0f;
-    float peak = 0.0f;
-    for (int i = 0; i < count; i++) {
-        if (mags[start + i] > peak) peak = mags[start + i];
+    if (input && index >= kNumChannels) {
+        port.hints = kAudioPortIsSidechain;
+        port.name = (index == kNumChannels) ? "Sidechain Left" : "Sidechain Right";
+        port.symbol = (index == kNumChannels) ? "sidechain_left" : "sidechain_right";
+        return;
     }
-    return peak;
-}
-
-float FrequencyGatePlugin::computeMedian(std::vector<float>& mags, int start, int count)
-{
-    if (count <= 0) return 0.0f;
-    std::vector<float> temp(mags.begin() + start, mags.begin() + start + count);
-    std::sort(temp.begin(), temp.end());
-    return (count % 2 == 0) ? (temp[count/2-1] + temp[count/2]) * 0.5f : temp[count/2];
-}
-
-float FrequencyGatePlugin::computeRMS(const std::vector<float>& mags, int start, int count)
-{
-    if (count <= 0) return 0.0f;
-    float sumSq = 0.0f;
-    for (int i = 0; i < count; i++) {
-        float m = mags[start + i];
-        sumSq += m * m;
-    }
-    return std::sqrt(sumSq / count);
-}
-
-float FrequencyGatePlugin::computeTrimmedMean(std::vector<float>& mags, int start, int count)
-{
-    if (count <= 4) return computeAverage(mags, start, count);
-    std::vector<float> temp(mags.begin() + start, mags.begin() + start + count);
-    std::sort(temp.begin(), temp.end());
-    int trim = std::max(1, count / 10);
-    float sum = 0.0f;
-    int tc = count - 2 * trim;
-    for (int i = trim; i < count - trim; i++) sum += temp[i];
-    return (tc > 0) ? sum / tc : computeAverage(mags, start, count);
+    Plugin::initAudioPort(input, index, port);
 }
 
 // Parameters
@@ -305,13 +73,15 @@ void FrequencyGatePlugin::initParameter(uint32_t index, Parameter& parameter)
                 v[2].label = "Median"; v[2].value = 2;
                 v[3].label = "RMS"; v[3].value = 3;
                 v[4].label = "Trimmed Mean"; v[4].value = 4;
+                v[5].label = "Voice (Flatness)"; v[5].value = 5;
+                v[6].label = "Voice (Harmonic)"; v[6].value = 6;
                 parameter.enumValues.values = v;
             }
             break;
         case kParamPreOpen:
             parameter.name = "Pre-Open"; parameter.symbol = "preopen"; parameter.unit = "ms";
             parameter.hints = kParameterIsAutomatable;
-            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 20.0f;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = MAX_PREOPEN_MS;
             break;
         case kParamAttack:
             parameter.name = "Attack"; parameter.symbol = "attack"; parameter.unit = "ms";
@@ -339,183 +109,206 @@ void FrequencyGatePlugin::initParameter(uint32_t index, Parameter& parameter)
             parameter.ranges.def = -96.0f; parameter.ranges.min = -96.0f; parameter.ranges.max = 0.0f;
             break;
         case kParamFFTSize:
-            parameter.name = "FFT Size"; parameter.symbol = "fft_size";
+            parameter.name = "FFT Window"; parameter.symbol = "fft_size";
             parameter.hints = kParameterIsAutomatable | kParameterIsInteger;
             parameter.ranges.def = 2.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = kFFTSizeCount - 1;
             parameter.enumValues.count = kFFTSizeCount;
             parameter.enumValues.restrictedMode = true;
             {
                 ParameterEnumerationValue* v = new ParameterEnumerationValue[kFFTSizeCount];
-                v[0].label = "512"; v[0].value = 0;
-                v[1].label = "1024"; v[1].value = 1;
-                v[2].label = "2048"; v[2].value = 2;
-                v[3].label = "4096"; v[3].value = 3;
+                // Windows in ms (512 .. 4096 points at 48 kHz, rescaled at other rates)
+                v[0].label = "10.7 ms"; v[0].value = 0;
+                v[1].label = "21.3 ms"; v[1].value = 1;
+                v[2].label = "42.7 ms"; v[2].value = 2;
+                v[3].label = "85.3 ms"; v[3].value = 3;
                 parameter.enumValues.values = v;
             }
             break;
+        case kParamGateMode:
+            parameter.name = "Gate Mode"; parameter.symbol = "gate_mode";
+            parameter.hints = kParameterIsAutomatable | kParameterIsInteger;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = kGateModeCount - 1;
+            parameter.enumValues.count = kGateModeCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* v = new ParameterEnumerationValue[kGateModeCount];
+                v[0].label = "Broadband"; v[0].value = 0;
+                v[1].label = "Spectral"; v[1].value = 1;
+                parameter.enumValues.values = v;
+            }
+            break;
+        case kParamAutoThreshold:
+            parameter.name = "Auto Threshold"; parameter.symbol = "auto_threshold";
+            parameter.hints = kParameterIsAutomatable | kParameterIsBoolean;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 1.0f;
+            break;
+        case kParamAutoMargin:
+            parameter.name = "Auto Margin"; parameter.symbol = "auto_margin"; parameter.unit = "dB";
+            parameter.hints = kParameterIsAutomatable;
+            parameter.ranges.def = 10.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 30.0f;
+            break;
+        case kParamNoiseFloor:
+            parameter.name = "Noise Floor"; parameter.symbol = "noise_floor"; parameter.unit = "dB";
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.def = -96.0f; parameter.ranges.min = -96.0f; parameter.ranges.max = 0.0f;
+            break;
+        case kParamShareGroup:
+            parameter.name = "Share Group"; parameter.symbol = "share_group";
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = MAX_SHARE_GROUPS;
+            break;
+        case kParamKeySource:
+            parameter.name = "Key Source"; parameter.symbol = "key_source";
+            parameter.hints = kParameterIsAutomatable | kParameterIsInteger;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = kKeySourceCount - 1;
+            parameter.enumValues.count = kKeySourceCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* v = new ParameterEnumerationValue[kKeySourceCount];
+                v[0].label = "Main"; v[0].value = 0;
+                v[1].label = "Sidechain"; v[1].value = 1;
+                parameter.enumValues.values = v;
+            }
+            break;
+        case kParamDspLoad:
+            parameter.name = "DSP Load"; parameter.symbol = "dsp_load"; parameter.unit = "%";
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 100.0f;
+            break;
+        case kParamDspPeak:
+            parameter.name = "DSP Peak"; parameter.symbol = "dsp_peak"; parameter.unit = "%";
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 100.0f;
+            break;
+        case kParamAveraging:
+            parameter.name = "Averaging"; parameter.symbol = "averaging"; parameter.unit = "ms";
+            parameter.hints = kParameterIsAutomatable;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = MAX_AVERAGING_MS;
+            break;
+        case kParamChannelDetect:
+            parameter.name = "Channel Detect"; parameter.symbol = "channel_detect";
+            parameter.hints = kParameterIsAutomatable | kParameterIsInteger;
+            parameter.ranges.def = 0.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = kChannelDetectCount - 1;
+            parameter.enumValues.count = kChannelDetectCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* v = new ParameterEnumerationValue[kChannelDetectCount];
+                v[0].label = "Mix"; v[0].value = 0;
+                v[1].label = "Max"; v[1].value = 1;
+                v[2].label = "Mean"; v[2].value = 2;
+                v[3].label = "Linked"; v[3].value = 3;
+                parameter.enumValues.values = v;
+            }
+            break;
+        default:
+            if (index >= kParamChannelWeight0 && index < kParamCount) {
+                const int channel = index - kParamChannelWeight0;
+                char name[32], symbol[32];
+                std::snprintf(name, sizeof(name), "Weight %s", getChannelLabel(channel));
+                std::snprintf(symbol, sizeof(symbol), "detect_weight_%d", channel + 1);
+                parameter.name = name; parameter.symbol = symbol;
+                parameter.hints = kParameterIsAutomatable;
+                parameter.ranges.def = 1.0f; parameter.ranges.min = 0.0f; parameter.ranges.max = 1.0f;
+            }
+            break;
     }
 }
 
 float FrequencyGatePlugin::getParameterValue(uint32_t index) const
 {
-    switch (index) {
-        case kParamFreqLow: return fFreqLow;
-        case kParamFreqHigh: return fFreqHigh;
-        case kParamThreshold: return fThreshold;
-        case kParamDetectionMethod: return fDetectionMethod;
-        case kParamPreOpen: return fPreOpen;
-        case kParamAttack: return fAttack;
-        case kParamHold: return fHold;
-        case kParamRelease: return fRelease;
-        case kParamHysteresis: return fHysteresis;
-        case kParamRange: return fRange;
-        case kParamFFTSize: return fFFTSizeOption;
-        default: return 0.0f;
-    }
+    if (index == kParamDspLoad) return fDspLoad;
+    if (index == kParamDspPeak) return fDspPeak;
+    return mDSP.getParameter(index);
 }
 
 void FrequencyGatePlugin::setParameterValue(uint32_t index, float value)
 {
-    switch (index) {
-        case kParamFreqLow: fFreqLow = value; computeBandBins(); break;
-        case kParamFreqHigh: fFreqHigh = value; computeBandBins(); break;
-        case kParamThreshold: fThreshold = value; break;
-        case kParamDetectionMethod: fDetectionMethod = value; break;
-        case kParamPreOpen:
-            if (fPreOpen != value) {
-                fPreOpen = value;
-                mLookaheadSamples = static_cast<int>(fPreOpen * mSampleRate / 1000.0);
-                if (mLookaheadSamples > 0) {
-                    mLookaheadBufferL.resize(mLookaheadSamples, 0.0f);
-                    mLookaheadBufferR.resize(mLookaheadSamples, 0.0f);
-                } else {
-                    mLookaheadBufferL.clear();
-                    mLookaheadBufferR.clear();
-                }
-                mLookaheadWritePos = 0;
-            }
-            break;
-        case kParamAttack: fAttack = value; break;
-        case kParamHold: fHold = value; break;
-        case kParamRelease: fRelease = value; break;
-        case kParamHysteresis: fHysteresis = value; break;
-        case kParamRange: fRange = value; break;
-        case kParamFFTSize:
-            if (static_cast<int>(fFFTSizeOption) != static_cast<int>(value)) {
-                fFFTSizeOption = value;
-                mNeedsReinit = true;
-            }
-            break;
-    }
+    // Latency is reported from run() only: Pre-Open changes reach the host on the next block
+    mDSP.setParameter(index, value);
 }
 
 // Processing
 void FrequencyGatePlugin::activate()
 {
-    initFFT();
-    mEnvelopeLevel = 0.0f;
-    mGateGain = dbToLinear(fRange);
-    mGateOpen = false;
-    mHoldCounter = 0;
+    mDSP.activate();
+    if (mCapture) mCapture->start(getSampleRate(), mDSP.getHopPhase());
+    updateLatency();
+    fDspLoad = 0.0f;
+    fDspPeak = 0.0f;
 }
 
-void FrequencyGatePlugin::deactivate() {}
+void FrequencyGatePlugin::deactivate() { mDSP.deactivate(); }
 
 void FrequencyGatePlugin::sampleRateChanged(double newSampleRate)
 {
-    mSampleRate = newSampleRate;
-    mNeedsReinit = true;
+    mDSP.setSampleRate(newSampleRate);
 }
 
-uint32_t FrequencyGatePlugin::getLatency() const noexcept
+void FrequencyGatePlugin::updateLatency()
 {
-    return static_cast<uint32_t>(mHopSize + mLookaheadSamples);
+    const uint32_t latency = mDSP.getLatency();
+    if (latency == mReportedLatency) return;
+    mReportedLatency = latency;
+    setLatency(latency);
 }
 
 void FrequencyGatePlugin::run(const float** inputs, float** outputs, uint32_t frames)
 {
-    if (mNeedsReinit) reinitFFT();
-    
-    const float* inL = inputs[0];
-    const float* inR = inputs[1];
-    float* outL = outputs[0];
-    float* outR = outputs[1];
-    
-    // Envelope coefficients
-    const float attackCoeff = std::exp(-1.0f / (static_cast<float>(mSampleRate) * fAttack / 1000.0f));
-    const float releaseCoeff = std::exp(-1.0f / (static_cast<float>(mSampleRate) * fRelease / 1000.0f));
-    const int holdSamples = static_cast<int>(fHold * mSampleRate / 1000.0f);
-    const float rangeGain = dbToLinear(fRange);
-    
-    // Thresholds with hysteresis
-    const float openThresh = fThreshold;
-    const float closeThresh = fThreshold - fHysteresis;
-    
-    for (uint32_t i = 0; i < frames; i++) {
-        float sL = inL[i];
-        float sR = inR[i];
-        
-        // Write to circular buffer (doubled for easy access)
-        mInputBufferL[mInputWritePos] = sL;
-        mInputBufferL[mInputWritePos + mCurrentFFTSize] = sL;
-        mInputBufferR[mInputWritePos] = sR;
-        mInputBufferR[mInputWritePos + mCurrentFFTSize] = sR;
-        
-        mInputWritePos = (mInputWritePos + 1) % mCurrentFFTSize;
-        mHopCounter++;
-        
-        // FFT at hop intervals
-        if (mHopCounter >= mHopSize) {
-            mHopCounter = 0;
-            
-            // Fill FFT input with windowed mono signal
-            int readPos = mInputWritePos; // Start from current pos (oldest sample in window)
-            for (int j = 0; j < mCurrentFFTSize; j++) {
-                float mono = (mInputBufferL[readPos + j] + mInputBufferR[readPos + j]) * 0.5f;
-                mFftInput[j] = mono * mWindow[j];
-            }
-            
-            float level = detectLevel();
-            
-            // Gate logic with hysteresis
-            bool shouldOpen = mGateOpen ? (level >= closeThresh) : (level >= openThresh);
-            
-            if (shouldOpen) {
-                mGateOpen = true;
-                mHoldCounter = holdSamples;
-            } else if (mHoldCounter > 0) {
-                mHoldCounter--;
-            } else {
-                mGateOpen = false;
-            }
-        }
-        
-        // Envelope follower
-        float target = mGateOpen ? 1.0f : 0.0f;
-        if (target > mEnvelopeLevel) {
-            mEnvelopeLevel = target - (target - mEnvelopeLevel) * attackCoeff;
-        } else if (mHoldCounter <= 0) {
-            mEnvelopeLevel = target + (mEnvelopeLevel - target) * releaseCoeff;
-        }
-        
-        // Compute gain
-        mGateGain = rangeGain + (1.0f - rangeGain) * mEnvelopeLevel;
-        
-        // Apply gate (with optional lookahead)
-        float gL, gR;
-        if (mLookaheadSamples > 0 && !mLookaheadBufferL.empty()) {
-            gL = mLookaheadBufferL[mLookaheadWritePos] * mGateGain;
-            gR = mLookaheadBufferR[mLookaheadWritePos] * mGateGain;
-            mLookaheadBufferL[mLookaheadWritePos] = sL;
-            mLookaheadBufferR[mLookaheadWritePos] = sR;
-            mLookaheadWritePos = (mLookaheadWritePos + 1) % mLookaheadSamples;
-        } else {
-            gL = sL * mGateGain;
-            gR = sR * mGateGain;
-        }
-        
-        outL[i] = gL;
-        outR[i] = gR;
+    // FFT size and gate mode changes take effect (and change the latency) inside process()
+    if (mCapture) mCapture->captureInput(mDSP, inputs, frames);   // Before: hosts may process in place
+    mDSP.process(inputs, outputs, frames);
+    if (mCapture) mCapture->captureOutput(mDSP, outputs, frames);
+    updateLatency();
+    updateLoad(frames);
+}
+
+// Time spent in the engine relative to the block's duration (stays 0 without instrumentation)
+void FrequencyGatePlugin::updateLoad(uint32_t frames)
+{
+    if (!GateStats::enabled() || frames == 0) return;
+    const double blockNs = frames * 1e9 / getSampleRate();
+    const float load = static_cast<float>(std::min(100.0, 100.0 * mDSP.getStats().lastBlockNs() / blockNs));
+    const float coeff = static_cast<float>(std::exp(-blockNs / (DSP_LOAD_SMOOTH_MS * 1e6)));
+    fDspLoad = load + (fDspLoad - load) * coeff;
+    fDspPeak = std::max(fDspPeak, load);
+}
+
+// Debug files of one instance share a name: <dir>/FrequencyGate-<date>-<time>-<n>.<extension>
+std::string FrequencyGatePlugin::makeDebugPath(const char* dir, const char* extension)
+{
+    if (mDebugName.empty()) {
+        static std::atomic<int> instanceCount{0};
+        const std::time_t now = std::time(nullptr);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+        char name[64];
+        std::snprintf(name, sizeof(name), "FrequencyGate-%s-%d", stamp, ++instanceCount);
+        mDebugName = name;
+    }
+    return std::string(dir) + "/" + mDebugName + "." + extension;
+}
+
+// One CSV per instance
+void FrequencyGatePlugin::openEventLog(const char* dir)
+{
+    const std::string path = makeDebugPath(dir, "csv");
+    mEventLog.reset(new GateEventRecorder());
+    if (!mEventLog->open(path)) {
+        d_stderr2("FrequencyGate: cannot write event log %s", path.c_str());
+        mEventLog.reset();
+        return;
+    }
+    mDSP.setEventRing(&mEventLog->ring());
+}
+
+// One capture per instance (see frequencygate-replay)
+void FrequencyGatePlugin::openCapture(const char* dir)
+{
+    const std::string path = makeDebugPath(dir, "fgcap");
+    mCapture.reset(new GateCaptureRecorder());
+    if (!mCapture->open(path, kNumChannels, DISTRHO_PLUGIN_NUM_INPUTS, mDSP.getSimdName())) {
+        d_stderr2("FrequencyGate: cannot write capture %s", path.c_str());
+        mCapture.reset();
     }
 }
 
@@ -8,15 +8,10 @@
 
 #include "DistrhoPlugin.hpp"
 #include "DistrhoPluginInfo.h"
-#include <vector>
-#include <cmath>
-#include <algorithm>
-
-#ifdef USE_PFFFT
-extern "C" {
-#include "pffft.h"
-}
-#endif
+#include "FrequencyGateDSP.hpp"
+#include "FrequencyGateCapture.hpp"
+#include <memory>
+#include <string>
 
 START_NAMESPACE_DISTRHO
 
@@ -38,11 +33,12 @@ protected:
     }
     const char* getHomePage() const noexcept override { return DISTRHO_PLUGIN_URI; }
     uint32_t getVersion() const noexcept override { return d_version(1, 0, 0); }
-    int64_t getUniqueId() const noexcept override { return d_cconst('F', 'q', 'G', 't'); }
+    int64_t getUniqueId() const noexcept override { return d_cconst('F', 'q', 'G', FREQUENCYGATE_ID_CHAR); }
 
     // --------------------------------------------------------------------------------------------------------
     // Init
 
+    void initAudioPort(bool input, uint32_t index, AudioPort& port) override;
     void initParameter(uint32_t index, Parameter& parameter) override;
 
     // --------------------------------------------------------------------------------------------------------
@@ -62,89 +58,35 @@ protected:
     // --------------------------------------------------------------------------------------------------------
     // Latency
     
-    uint32_t getLatency() const noexcept;
-
-private:
-    // Parameters
-    float fFreqLow;          // Detection range low frequency (Hz)
-    float fFreqHigh;         // Detection range high frequency (Hz)
-    float fThreshold;        // Gate threshold (dB)
-    float fDetectionMethod;  // Detection algorithm
-    float fPreOpen;          // Lookahead (ms)
-    float fAttack;           // Attack time (ms)
-    float fHold;             // Hold time (ms)
-    float fRelease;          // Release time (ms)
-    float fHysteresis;       // Hysteresis (dB)
-    float fRange;            // Gate attenuation (dB)
-    float fFFTSizeOption;    // FFT size selection
-
-    // Internal state
-    double mSampleRate;
-    int mCurrentFFTSize;
-    int mHopSize;
-    bool mNeedsReinit;
-    
-    // FFT setup (PFFFT)
-#ifdef USE_PFFFT
-    PFFFT_Setup* mPffftSetup;
-#endif
-    float* mFftInput;
-    float* mFftOutput;
-    float* mWorkBuffer;
-    
-    // Window function
-    std::vector<float> mWindow;
-    std::vector<float> mWindowSum;
-    float mWindowGain;  // Amplitude correction factor for window
-    
-    // Circular buffers (doubled for easy access)
-    std::vector<float> mInputBufferL;
-    std::vector<float> mInputBufferR;
-    std::vector<float> mOutputBufferL;
-    std::vector<float> mOutputBufferR;
+    uint32_t getLatency() const noexcept { return mDSP.getLatency(); }
+    void updateLatency();
     
-    // Lookahead delay line
-    std::vector<float> mLookaheadBufferL;
-    std::vector<float> mLookaheadBufferR;
-    int mLookaheadWritePos;
-    int mLookaheadSamples;
+    // --------------------------------------------------------------------------------------------------------
+    // DSP load meters
     
-    // Buffer positions
-    int mInputWritePos;
-    int mOutputReadPos;
-    int mHopCounter;
+    void updateLoad(uint32_t frames);
     
-    // Gate envelope state
-    float mEnvelopeLevel;      // Current envelope (0.0 to 1.0)
-    float mGateGain;           // Current gate gain (linear)
-    bool mGateOpen;            // Gate state for hysteresis
-    int mHoldCounter;          // Hold timer (samples)
+    // --------------------------------------------------------------------------------------------------------
+    // Event log
     
-    // Frequency bin cache
-    int mStartBin;
-    int mEndBin;
+    void openEventLog(const char* dir);
     
-    // Temporary buffer for detection
-    std::vector<float> mMagnitudes;
+    // --------------------------------------------------------------------------------------------------------
+    // Session capture (debug)
     
-    // Helper functions
-    void initFFT();
-    void freeFFT();
-    void reinitFFT();
-    void createWindow();
-    void computeBandBins();
-    float detectLevel();
-    float computeAverage(const std::vector<float>& mags, int start, int count);
-    float computePeak(const std::vector<float>& mags, int start, int count);
-    float computeMedian(std::vector<float>& mags, int start, int count);
-    float computeRMS(const std::vector<float>& mags, int start, int count);
-    float computeTrimmedMean(std::vector<float>& mags, int start, int count);
-    float linearToDb(float linear);
-    float dbToLinear(float db);
+    void openCapture(const char* dir);
+    std::string makeDebugPath(const char* dir, const char* extension);
+
+private:
+    static const int kNumChannels = FREQUENCYGATE_NUM_CHANNELS;
     
-    // Aligned memory allocation
-    static void* alignedAlloc(size_t size);
-    static void alignedFree(void* ptr);
+    FrequencyGateDSP mDSP;
+    uint32_t mReportedLatency;
+    float fDspLoad;   // Output: smoothed processing time (% of realtime)
+    float fDspPeak;   // Output: worst block since activation (% of realtime)
+    std::unique_ptr<GateEventRecorder> mEventLog;   // Only with FREQUENCYGATE_EVENT_LOG set
+    std::unique_ptr<GateCaptureRecorder> mCapture;  // Only with FREQUENCYGATE_CAPTURE set
+    std::string mDebugName;   // Event log and capture file name, chosen on first use
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrequencyGatePlugin)
 };
@@ -0,0 +1,107 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Parameter names and preset files for the offline tools
+ *
+ * Parameters are addressed by the same symbols the plugin exports (freq_low,
+ * threshold, ...). A preset file holds one "symbol = value" per line; '#' starts
+ * a comment. Values are clamped to the plugin's ranges.
+ */
+
+#ifndef FREQUENCY_GATE_PRESETS_HPP_INCLUDED
+#define FREQUENCY_GATE_PRESETS_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FrequencyGatePresets {
+
+struct ParamSpec {
+    const char* symbol;
+    uint32_t index;
+    float min;
+    float max;
+};
+
+// Host-facing parameters that make sense offline (no output, share group or sidechain key)
+static const ParamSpec kParamSpecs[] = {
+    { "freq_low",        kParamFreqLow,         20.0f, 20000.0f },
+    { "freq_high",       kParamFreqHigh,        20.0f, 20000.0f },
+    { "threshold",       kParamThreshold,      -96.0f, 0.0f },
+    { "detection",       kParamDetectionMethod,  0.0f, kDetectCount - 1 },
+    { "preopen",         kParamPreOpen,          0.0f, MAX_PREOPEN_MS },
+    { "attack",          kParamAttack,           0.1f, 100.0f },
+    { "hold",            kParamHold,             0.0f, 500.0f },
+    { "release",         kParamRelease,          1.0f, 1000.0f },
+    { "hysteresis",      kParamHysteresis,       0.0f, 12.0f },
+    { "range",           kParamRange,          -96.0f, 0.0f },
+    { "fft_size",        kParamFFTSize,          0.0f, kFFTSizeCount - 1 },
+    { "gate_mode",       kParamGateMode,         0.0f, kGateModeCount - 1 },
+    { "auto_threshold",  kParamAutoThreshold,    0.0f, 1.0f },
+    { "auto_margin",     kParamAutoMargin,       0.0f, 30.0f },
+    { "averaging",       kParamAveraging,        0.0f, MAX_AVERAGING_MS },
+    { "channel_detect",  kParamChannelDetect,    0.0f, kChannelDetectCount - 1 },
+};
+
+typedef std::vector<std::pair<uint32_t, float>> ParamList;
+
+// Resolve a symbol (also detect_weight_1..16) and clamp the value; false if unknown
+inline bool resolve(const std::string& symbol, float value, std::pair<uint32_t, float>& out)
+{
+    for (const ParamSpec& spec : kParamSpecs) {
+        if (symbol == spec.symbol) {
+            out = std::make_pair(spec.index, std::max(spec.min, std::min(spec.max, value)));
+            return true;
+        }
+    }
+    int channel = 0;
+    if (std::sscanf(symbol.c_str(), "detect_weight_%d", &channel) == 1 && channel >= 1 && channel <= MAX_CHANNELS) {
+        out = std::make_pair(static_cast<uint32_t>(kParamChannelWeight0 + channel - 1),
+                             std::max(0.0f, std::min(1.0f, value)));
+        return true;
+    }
+    return false;
+}
+
+inline bool parseValue(const std::string& text, float& value)
+{
+    char* end = nullptr;
+    value = std::strtof(text.c_str(), &end);
+    return end && end != text.c_str() && *end == '\0';
+}
+
+inline bool loadPreset(const std::string& path, ParamList& params, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open preset " + path;
+        return false;
+    }
+    std::string line;
+    for (int lineNo = 1; std::getline(file, line); lineNo++) {
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), '=', ' ');
+        char symbol[64], valueText[64];
+        const int fields = std::sscanf(line.c_str(), "%63s %63s", symbol, valueText);
+        if (fields <= 0) continue;
+        float value;
+        std::pair<uint32_t, float> param;
+        if (fields != 2 || !parseValue(valueText, value) || !resolve(symbol, value, param)) {
+            error = path + ":" + std::to_string(lineNo) + ": expected '<parameter> = <number>'";
+            return false;
+        }
+        params.push_back(param);
+    }
+    return true;
+}
+
+} // namespace FrequencyGatePresets
+
+#endif // FREQUENCY_GATE_PRESETS_HPP_INCLUDED
@@ -0,0 +1,117 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Shared analysis bus
+ *
+ * Process-local registry that lets instances with the same share group reuse one
+ * detector. The first instance to claim a group becomes its leader and publishes
+ * each hop's gate decision; the others follow it and only run envelope and gain.
+ * Everything is lock-free: the leader is one atomic pointer per group, and a
+ * decision is packed into a single 64-bit word so readers never see a torn update.
+ * The last SHARE_HISTORY decisions are kept, so a follower processed after its leader
+ * can apply them hop by hop instead of jumping to the newest.
+ */
+
+#ifndef FREQUENCY_GATE_SHARED_BUS_HPP_INCLUDED
+#define FREQUENCY_GATE_SHARED_BUS_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace SharedAnalysisBus {
+
+const uint32_t kSeqMask = 0x1FFFFFFFu;   // Sequence numbers wrap at 29 bits
+
+struct Decision {
+    uint32_t seq;      // Incremented by the leader on every hop
+    bool open;         // Gate state after hysteresis and hold
+    bool holding;      // Hold timer running (envelope must not release)
+    bool measured;     // Level is new this hop (clear while a new leader warms up)
+    float level;       // Detection level (dB) the decision was made from
+};
+
+struct Slot {
+    std::atomic<const void*> leader{nullptr};
+    std::atomic<uint32_t> latest{0};                    // Sequence of the newest decision
+    std::atomic<uint64_t> history[SHARE_HISTORY] {};    // Decision words, indexed by seq
+};
+
+// group is 1..MAX_SHARE_GROUPS
+inline Slot& slot(int group)
+{
+    static Slot slots[MAX_SHARE_GROUPS];
+    return slots[group - 1];
+}
+
+inline const void* leader(int group)
+{
+    return slot(group).leader.load(std::memory_order_acquire);
+}
+
+// Become leader if the current leader is still `expected` (nullptr for a free group)
+inline bool claim(int group, const void* expected, const void* owner)
+{
+    return slot(group).leader.compare_exchange_strong(expected, owner, std::memory_order_acq_rel);
+}
+
+inline void release(int group, const void* owner)
+{
+    const void* expected = owner;
+    slot(group).leader.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+}
+
+// Word layout: [63..35] seq (29 bits) | [34] measured | [33] holding | [32] open | [31..0] level bits
+inline uint64_t pack(const Decision& d)
+{
+    uint32_t levelBits;
+    std::memcpy(&levelBits, &d.level, sizeof(levelBits));
+    return (static_cast<uint64_t>(d.seq & kSeqMask) << 35)
+         | (static_cast<uint64_t>(d.measured) << 34)
+         | (static_cast<uint64_t>(d.holding) << 33)
+         | (static_cast<uint64_t>(d.open) << 32)
+         | levelBits;
+}
+
+inline Decision unpack(uint64_t word)
+{
+    Decision d;
+    d.seq = static_cast<uint32_t>(word >> 35);
+    d.measured = ((word >> 34) & 1u) != 0;
+    d.holding = ((word >> 33) & 1u) != 0;
+    d.open = ((word >> 32) & 1u) != 0;
+    const uint32_t levelBits = static_cast<uint32_t>(word);
+    std::memcpy(&d.level, &levelBits, sizeof(d.level));
+    return d;
+}
+
+// SHARE_HISTORY divides 2^29, so the index stays continuous across the wrap
+inline void publish(int group, const Decision& d)
+{
+    Slot& s = slot(group);
+    s.history[d.seq % SHARE_HISTORY].store(pack(d), std::memory_order_release);
+    s.latest.store(d.seq & kSeqMask, std::memory_order_release);
+}
+
+inline uint32_t latest(int group)
+{
+    return slot(group).latest.load(std::memory_order_acquire);
+}
+
+// Newest decision
+inline Decision read(int group)
+{
+    Slot& s = slot(group);
+    return unpack(s.history[s.latest.load(std::memory_order_acquire) % SHARE_HISTORY].load(std::memory_order_acquire));
+}
+
+// Decision `seq`; false once it has been overwritten (or was never published)
+inline bool read(int group, uint32_t seq, Decision& d)
+{
+    d = unpack(slot(group).history[seq % SHARE_HISTORY].load(std::memory_order_acquire));
+    return d.seq == (seq & kSeqMask);
+}
+
+} // namespace SharedAnalysisBus
+
+#endif // FREQUENCY_GATE_SHARED_BUS_HPP_INCLUDED
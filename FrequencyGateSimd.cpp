@@ -0,0 +1,148 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Instruction set dispatch (see FrequencyGateSimd.hpp)
+ */
+
+#include "FrequencyGateSimd.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FREQUENCYGATE_SIMD_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace FrequencyGateSimd {
+
+// Variants, built with their instruction set enabled (FrequencyGateSimdVariant.cpp)
+#ifdef FREQUENCYGATE_SIMD_AVX2
+const Backend& backend_avx2();
+#endif
+#ifdef FREQUENCYGATE_SIMD_AVX512
+const Backend& backend_avx512();
+#endif
+
+#if defined(FREQUENCYGATE_SIMD_X86)
+static const char* const kBaselineName = "sse2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+static const char* const kBaselineName = "neon";
+#else
+static const char* const kBaselineName = "generic";
+#endif
+
+static const Backend kBaselineBackend = FREQUENCYGATE_SIMD_BACKEND(kBaselineName);
+
+#ifdef FREQUENCYGATE_SIMD_X86
+static void cpuid(uint32_t leaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), 0);
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(r[i]);
+#else
+    if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3])) regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0)
+static uint64_t osStateMask()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+// Widest level the CPU and OS can run, whether built or not
+static Level detect()
+{
+#ifdef FREQUENCYGATE_SIMD_X86
+    uint32_t leaf0[4], leaf1[4], leaf7[4];
+    cpuid(0, leaf0);
+    if (leaf0[0] < 7) return kBaseline;
+    cpuid(1, leaf1);
+    cpuid(7, leaf7);
+    if (!(leaf1[2] & (1u << 27))) return kBaseline;                 // OSXSAVE: XCR0 readable
+    const uint64_t state = osStateMask();
+    const bool avx2 = (state & 0x06) == 0x06                        // XMM, YMM
+        && (leaf1[2] & (1u << 28)) && (leaf1[2] & (1u << 12))       // AVX, FMA
+        && (leaf7[1] & (1u << 5));                                  // AVX2
+    if (!avx2) return kBaseline;
+    const uint32_t avx512Bits = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31);   // F, DQ, BW, VL
+    const bool avx512 = (state & 0xE6) == 0xE6                      // + opmask, ZMM
+        && (leaf7[1] & avx512Bits) == avx512Bits;
+    return avx512 ? kAvx512 : kAvx2;
+#else
+    return kBaseline;
+#endif
+}
+
+const char* levelName(Level level)
+{
+    switch (level) {
+        case kBaseline: return kBaselineName;
+        case kAvx2: return "avx2";
+        case kAvx512: return "avx512";
+        default: return "auto";
+    }
+}
+
+bool compiled(Level level)
+{
+    switch (level) {
+        case kBaseline: return true;
+#ifdef FREQUENCYGATE_SIMD_AVX2
+        case kAvx2: return true;
+#endif
+#ifdef FREQUENCYGATE_SIMD_AVX512
+        case kAvx512: return true;
+#endif
+        default: return false;
+    }
+}
+
+bool supported(Level level)
+{
+    static const Level detected = detect();
+    return compiled(level) && level <= detected;
+}
+
+Level select()
+{
+    static const Level selected = [] {
+        int level = kLevelCount - 1;
+        while (level > kBaseline && !supported(static_cast<Level>(level))) level--;
+        if (const char* cap = std::getenv("FREQUENCYGATE_SIMD")) {
+            for (int k = kBaseline; k < level; k++)
+                if (std::strcmp(cap, levelName(static_cast<Level>(k))) == 0) level = k;
+        }
+        return static_cast<Level>(level);
+    }();
+    return selected;
+}
+
+const Backend& backend(Level level)
+{
+    if (level == kAuto || !supported(level)) level = select();
+    switch (level) {
+#ifdef FREQUENCYGATE_SIMD_AVX2
+        case kAvx2: return backend_avx2();
+#endif
+#ifdef FREQUENCYGATE_SIMD_AVX512
+        case kAvx512: return backend_avx512();
+#endif
+        default: return kBaselineBackend;
+    }
+}
+
+} // namespace FrequencyGateSimd
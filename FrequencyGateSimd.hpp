@@ -0,0 +1,73 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Instruction set dispatch
+ *
+ * PFFFT and the hot kernels of FrequencyGateKernels.hpp are compiled once per instruction
+ * set into the same binary: the target's baseline (SSE2 on x86-64, NEON on AArch64) and,
+ * on x86-64, AVX2+FMA and AVX-512. Each engine takes the widest backend the CPU and OS
+ * support (CPUID, XGETBV) when it is constructed and keeps it, so FFT setups are only ever
+ * used by the build that made them. FREQUENCYGATE_SIMD=sse2|avx2|avx512 in the environment
+ * caps the choice.
+ */
+
+#ifndef FREQUENCY_GATE_SIMD_HPP_INCLUDED
+#define FREQUENCY_GATE_SIMD_HPP_INCLUDED
+
+#include "FrequencyGateKernels.hpp"
+
+#ifdef USE_PFFFT
+extern "C" {
+#include "pffft.h"
+}
+#endif
+
+namespace FrequencyGateSimd {
+
+enum Level {
+    kAuto = -1,     // Widest supported level (see select())
+    kBaseline = 0,  // What the build targets anyway
+    kAvx2,          // AVX2 + FMA
+    kAvx512,        // AVX-512 F/DQ/BW/VL
+    kLevelCount
+};
+
+// Kernels with a copy per level. They run once per segment or hop, so the indirect call is noise.
+#define FREQUENCYGATE_SIMD_KERNELS(X)                                                       \
+    X(sum) X(sumLog2) X(applyWindow) X(weightedMean) X(envelopeGain) X(averageSpectrum)     \
+    X(applyGain) X(delayApplyGain) X(binPower) X(maxBinPower) X(bandPower) X(packPair)      \
+    X(pairBandPower) X(maxPower) X(accumulate) X(accumulateMagnitude) X(scale) X(scaledSqrt)  \
+    X(fill) X(smoothMask) X(applyMask) X(overlapAdd)
+
+struct Backend {
+    const char* name;
+#ifdef USE_PFFFT
+    PFFFT_Setup* (*newSetup)(int size, pffft_transform_t transform);
+    void (*destroySetup)(PFFFT_Setup* setup);
+    void (*transformOrdered)(PFFFT_Setup* setup, const float* input, float* output, float* work,
+                             pffft_direction_t direction);
+#endif
+#define FREQUENCYGATE_SIMD_MEMBER(kernel) decltype(&FrequencyGateKernels::kernel) kernel;
+    FREQUENCYGATE_SIMD_KERNELS(FREQUENCYGATE_SIMD_MEMBER)
+#undef FREQUENCYGATE_SIMD_MEMBER
+};
+
+// Backend made of the PFFFT build and kernels visible in the including translation unit
+#define FREQUENCYGATE_SIMD_ENTRY(kernel) &FrequencyGateKernels::kernel,
+#ifdef USE_PFFFT
+#define FREQUENCYGATE_SIMD_BACKEND(name)                                                    \
+    { name, &pffft_new_setup, &pffft_destroy_setup, &pffft_transform_ordered,               \
+      FREQUENCYGATE_SIMD_KERNELS(FREQUENCYGATE_SIMD_ENTRY) }
+#else
+#define FREQUENCYGATE_SIMD_BACKEND(name)                                                    \
+    { name, FREQUENCYGATE_SIMD_KERNELS(FREQUENCYGATE_SIMD_ENTRY) }
+#endif
+
+const char* levelName(Level level);
+bool compiled(Level level);             // Built into this binary
+bool supported(Level level);            // Built, and the CPU and OS can run it
+Level select();                         // Widest supported level, capped by FREQUENCYGATE_SIMD
+const Backend& backend(Level level);    // kAuto or an unsupported level: select()
+
+} // namespace FrequencyGateSimd
+
+#endif // FREQUENCY_GATE_SIMD_HPP_INCLUDED
@@ -0,0 +1,10 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * PFFFT built for one instruction set variant (see FrequencyGateSimdVariant.h)
+ *
+ * PFFFT's float path uses 4-lane vectors on every x86 build; a variant compiled for AVX2 or
+ * AVX-512 keeps that width but gains VEX/EVEX encoding and fused multiply-adds.
+ */
+
+#include "FrequencyGateSimdVariant.h"
+#include "pffft.c"
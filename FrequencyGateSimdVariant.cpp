@@ -0,0 +1,23 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Backend of one instruction set variant
+ *
+ * Compiled once per variant with that instruction set enabled (see CMakeLists.txt), so the
+ * kernels below vectorize for it; paired with the PFFFT build of FrequencyGateSimdPffft.c.
+ */
+
+#include "FrequencyGateSimdVariant.h"
+#include "FrequencyGateSimd.hpp"
+
+#define FREQUENCYGATE_SIMD_STRING2(variant) #variant
+#define FREQUENCYGATE_SIMD_STRING(variant) FREQUENCYGATE_SIMD_STRING2(variant)
+
+namespace FrequencyGateSimd {
+
+const Backend& FREQUENCYGATE_SIMD_NAME(backend)()
+{
+    static const Backend backend = FREQUENCYGATE_SIMD_BACKEND(FREQUENCYGATE_SIMD_STRING(FREQUENCYGATE_SIMD_VARIANT));
+    return backend;
+}
+
+} // namespace FrequencyGateSimd
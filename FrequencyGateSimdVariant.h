@@ -0,0 +1,40 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Naming of one instruction set variant
+ *
+ * Included first by the sources compiled once per instruction set (FrequencyGateSimdPffft.c,
+ * FrequencyGateSimdVariant.cpp). FREQUENCYGATE_SIMD_VARIANT names the set (avx2, avx512);
+ * every public PFFFT symbol gets it as a suffix, so several builds of pffft.c link into one
+ * binary. The list covers both the original PFFFT and the marton78 fork.
+ */
+
+#ifndef FREQUENCY_GATE_SIMD_VARIANT_H_INCLUDED
+#define FREQUENCY_GATE_SIMD_VARIANT_H_INCLUDED
+
+#ifndef FREQUENCYGATE_SIMD_VARIANT
+#error "FREQUENCYGATE_SIMD_VARIANT must name the instruction set of this build"
+#endif
+
+#define FREQUENCYGATE_SIMD_CAT2(name, variant) name##_##variant
+#define FREQUENCYGATE_SIMD_CAT(name, variant) FREQUENCYGATE_SIMD_CAT2(name, variant)
+#define FREQUENCYGATE_SIMD_NAME(name) FREQUENCYGATE_SIMD_CAT(name, FREQUENCYGATE_SIMD_VARIANT)
+
+#define pffft_new_setup FREQUENCYGATE_SIMD_NAME(pffft_new_setup)
+#define pffft_destroy_setup FREQUENCYGATE_SIMD_NAME(pffft_destroy_setup)
+#define pffft_transform FREQUENCYGATE_SIMD_NAME(pffft_transform)
+#define pffft_transform_ordered FREQUENCYGATE_SIMD_NAME(pffft_transform_ordered)
+#define pffft_zreorder FREQUENCYGATE_SIMD_NAME(pffft_zreorder)
+#define pffft_zconvolve_accumulate FREQUENCYGATE_SIMD_NAME(pffft_zconvolve_accumulate)
+#define pffft_zconvolve_no_accu FREQUENCYGATE_SIMD_NAME(pffft_zconvolve_no_accu)
+#define pffft_aligned_malloc FREQUENCYGATE_SIMD_NAME(pffft_aligned_malloc)
+#define pffft_aligned_free FREQUENCYGATE_SIMD_NAME(pffft_aligned_free)
+#define pffft_simd_size FREQUENCYGATE_SIMD_NAME(pffft_simd_size)
+#define pffft_simd_arch FREQUENCYGATE_SIMD_NAME(pffft_simd_arch)
+#define pffft_is_power_of_two FREQUENCYGATE_SIMD_NAME(pffft_is_power_of_two)
+#define pffft_is_valid_size FREQUENCYGATE_SIMD_NAME(pffft_is_valid_size)
+#define pffft_nearest_transform_size FREQUENCYGATE_SIMD_NAME(pffft_nearest_transform_size)
+#define pffft_min_fft_size FREQUENCYGATE_SIMD_NAME(pffft_min_fft_size)
+#define validate_pffft_simd FREQUENCYGATE_SIMD_NAME(validate_pffft_simd)
+#define validate_pffft_simd_ex FREQUENCYGATE_SIMD_NAME(validate_pffft_simd_ex)
+
+#endif /* FREQUENCY_GATE_SIMD_VARIANT_H_INCLUDED */
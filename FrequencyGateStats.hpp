@@ -0,0 +1,168 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Hot-path instrumentation
+ *
+ * Per-instance counters written by the audio thread and read from anywhere else
+ * (UI meters, the tools' statistics dumps). The audio thread is the only writer, so
+ * every update is a relaxed load and store: no locked read-modify-write and no fences
+ * in the process loop. Readers see each counter atomically, but a snapshot taken
+ * mid-block may mix counters from two consecutive blocks.
+ *
+ * Building with FREQUENCYGATE_INSTRUMENTATION=0 compiles every hook to nothing and
+ * leaves the class empty; snapshots then read as zero.
+ */
+
+#ifndef FREQUENCY_GATE_STATS_HPP_INCLUDED
+#define FREQUENCY_GATE_STATS_HPP_INCLUDED
+
+#include "DistrhoPluginInfo.h"
+#include <cstdint>
+#include <cstdio>
+
+#if FREQUENCYGATE_INSTRUMENTATION
+#include <atomic>
+#include <chrono>
+#endif
+
+class GateStats
+{
+public:
+    // Block time histogram: bucket k counts blocks that took [2^k, 2^(k+1)) ns
+    static const int kHistogramBuckets = 32;
+
+    struct Snapshot {
+        uint64_t blocks = 0;              // process() calls
+        uint64_t frames = 0;
+        uint64_t blockNs = 0;             // Total time inside process()
+        uint64_t blockNsMax = 0;          // Worst block
+        uint64_t hops = 0;                // Hop decisions (analyzed, shared or injected)
+        uint64_t analyses = 0;            // Hops that ran the FFT and detection
+        uint64_t analysisNs = 0;
+        uint64_t analysisNsMax = 0;
+        uint64_t reinits = 0;             // FFT / buffer reallocations
+        uint64_t transitions = 0;         // Gate opened or closed
+        uint64_t histogram[kHistogramBuckets] = {};
+    };
+
+#if FREQUENCYGATE_INSTRUMENTATION
+    static bool enabled() { return true; }
+
+    // Monotonic nanoseconds (a vDSO / QPC read, not a syscall on the supported platforms)
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Audio thread
+    void addBlock(uint64_t start, uint32_t frames)
+    {
+        if (mResetRequested.load(std::memory_order_relaxed)) clear();
+        const uint64_t ns = now() - start;
+        bump(mBlocks);
+        add(mFrames, frames);
+        add(mBlockNs, ns);
+        raise(mBlockNsMax, ns);
+        bump(mHistogram[bucket(ns)]);
+        mLastBlockNs.store(ns, std::memory_order_relaxed);
+    }
+    void addHop() { bump(mHops); }
+    void addAnalysis(uint64_t start)
+    {
+        const uint64_t ns = now() - start;
+        bump(mAnalyses);
+        add(mAnalysisNs, ns);
+        raise(mAnalysisNsMax, ns);
+    }
+    void addReinit() { bump(mReinits); }
+    void addTransition() { bump(mTransitions); }
+
+    // Time spent in the most recent process() call (for load meters)
+    uint64_t lastBlockNs() const { return mLastBlockNs.load(std::memory_order_relaxed); }
+
+    // Any thread
+    Snapshot snapshot() const
+    {
+        Snapshot s;
+        s.blocks = mBlocks.load(std::memory_order_relaxed);
+        s.frames = mFrames.load(std::memory_order_relaxed);
+        s.blockNs = mBlockNs.load(std::memory_order_relaxed);
+        s.blockNsMax = mBlockNsMax.load(std::memory_order_relaxed);
+        s.hops = mHops.load(std::memory_order_relaxed);
+        s.analyses = mAnalyses.load(std::memory_order_relaxed);
+        s.analysisNs = mAnalysisNs.load(std::memory_order_relaxed);
+        s.analysisNsMax = mAnalysisNsMax.load(std::memory_order_relaxed);
+        s.reinits = mReinits.load(std::memory_order_relaxed);
+        s.transitions = mTransitions.load(std::memory_order_relaxed);
+        for (int k = 0; k < kHistogramBuckets; k++) s.histogram[k] = mHistogram[k].load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // The audio thread clears the counters at its next block (it is the only writer)
+    void requestReset() { mResetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    typedef std::atomic<uint64_t> Counter;
+
+    static void bump(Counter& c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    static void add(Counter& c, uint64_t v) { c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed); }
+    static void raise(Counter& c, uint64_t v) { if (v > c.load(std::memory_order_relaxed)) c.store(v, std::memory_order_relaxed); }
+
+    static int bucket(uint64_t ns)
+    {
+        int k = 0;
+        while (ns > 1 && k < kHistogramBuckets - 1) { ns >>= 1; k++; }
+        return k;
+    }
+
+    void clear()
+    {
+        Counter* counters[] = { &mBlocks, &mFrames, &mBlockNs, &mBlockNsMax, &mHops, &mAnalyses,
+                                &mAnalysisNs, &mAnalysisNsMax, &mReinits, &mTransitions, &mLastBlockNs };
+        for (Counter* c : counters) c->store(0, std::memory_order_relaxed);
+        for (Counter& c : mHistogram) c.store(0, std::memory_order_relaxed);
+        mResetRequested.store(false, std::memory_order_relaxed);
+    }
+
+    Counter mBlocks{0}, mFrames{0}, mBlockNs{0}, mBlockNsMax{0};
+    Counter mHops{0}, mAnalyses{0}, mAnalysisNs{0}, mAnalysisNsMax{0};
+    Counter mReinits{0}, mTransitions{0}, mLastBlockNs{0};
+    Counter mHistogram[kHistogramBuckets] = {};
+    std::atomic<bool> mResetRequested{false};
+#else
+    static bool enabled() { return false; }
+    static uint64_t now() { return 0; }
+    void addBlock(uint64_t, uint32_t) {}
+    void addHop() {}
+    void addAnalysis(uint64_t) {}
+    void addReinit() {}
+    void addTransition() {}
+    uint64_t lastBlockNs() const { return 0; }
+    Snapshot snapshot() const { return Snapshot(); }
+    void requestReset() {}
+#endif
+};
+
+// One-line summary plus the non-empty histogram buckets, for the tools' statistics dumps
+inline void printGateStats(FILE* out, const char* label, const GateStats::Snapshot& s, double sampleRate)
+{
+    if (!GateStats::enabled()) {
+        std::fprintf(out, "%s: instrumentation disabled in this build\n", label);
+        return;
+    }
+    const double audioNs = sampleRate > 0.0 ? s.frames * 1e9 / sampleRate : 0.0;
+    std::fprintf(out, "%s: %llu blocks, load %.2f%%, block avg %.1f us max %.1f us | "
+                      "%llu hops, analysis avg %.1f us max %.1f us | %llu reinits, %llu transitions\n",
+                 label, static_cast<unsigned long long>(s.blocks), audioNs > 0.0 ? 100.0 * s.blockNs / audioNs : 0.0,
+                 s.blocks ? s.blockNs / 1e3 / s.blocks : 0.0, s.blockNsMax / 1e3,
+                 static_cast<unsigned long long>(s.hops), s.analyses ? s.analysisNs / 1e3 / s.analyses : 0.0,
+                 s.analysisNsMax / 1e3, static_cast<unsigned long long>(s.reinits),
+                 static_cast<unsigned long long>(s.transitions));
+    for (int k = 0; k < GateStats::kHistogramBuckets; k++) {
+        if (s.histogram[k] == 0) continue;
+        std::fprintf(out, "  blocks %8.1f - %8.1f us: %llu\n", (1ull << k) / 1e3, (2ull << k) / 1e3,
+                     static_cast<unsigned long long>(s.histogram[k]));
+    }
+}
+
+#endif // FREQUENCY_GATE_STATS_HPP_INCLUDED
@@ -19,18 +19,27 @@
 
 START_NAMESPACE_DISTRHO
 
-static const char* const kDetectNames[] = {"Average", "Peak", "Median", "RMS", "Trimmed Mean"};
-static const char* const kFFTNames[] = {"512", "1024", "2048", "4096"};
+static const char* const kDetectNames[] = {"Average", "Peak", "Median", "RMS", "Trimmed Mean",
+                                           "Voice (Flatness)", "Voice (Harmonic)"};
+static const char* const kFFTNames[] = {"10.7 ms", "21.3 ms", "42.7 ms", "85.3 ms"};
+static const char* const kGateModeNames[] = {"Broadband", "Spectral"};
+static const char* const kOffOnNames[] = {"Off", "On"};
+static const char* const kKeySourceNames[] = {"Main", "Sidechain"};
+static const char* const kChannelDetectNames[] = {"Mix", "Max", "Mean", "Linked"};
+static const char* const kShareGroupNames[] = {"Off", "1", "2", "3", "4", "5", "6", "7", "8",
+                                               "9", "10", "11", "12", "13", "14", "15", "16"};
+static const int kShareGroupCount = MAX_SHARE_GROUPS + 1;
 
 class FrequencyGateUI : public UI
 {
 public:
     FrequencyGateUI()
-        : UI(660, 700)
+        : UI(660, 1100)
         , mFontId(-1), mFontLoaded(false)
         , mDragging(-1), mDragY(0), mDragVal(0)
     {
         for (int i = 0; i < kParamCount; i++) fP[i] = 0.0f;
+        for (int c = 0; c < FREQUENCYGATE_NUM_CHANNELS; c++) fP[kParamChannelWeight0 + c] = 1.0f;
         fP[kParamFreqLow] = 100.0f;
         fP[kParamFreqHigh] = 500.0f;
         fP[kParamThreshold] = -30.0f;
@@ -40,6 +49,8 @@ public:
         fP[kParamHysteresis] = 3.0f;
         fP[kParamRange] = -96.0f;
         fP[kParamFFTSize] = 2.0f;
+        fP[kParamAutoMargin] = 10.0f;
+        fP[kParamNoiseFloor] = -96.0f;
         
         for (int i = 0; i < kParamCount; i++) mA[i] = {0,0,0,0};
         tryLoadFont();
@@ -66,8 +77,16 @@ protected:
         
         // Header
         beginPath(); rect(0, 0, W, 60); fillColor(32, 32, 40); fill();
-        txt(25, 30, "FrequencyGate", 32, Color(240, 240, 250), ALIGN_LEFT | ALIGN_MIDDLE);
+        txt(25, 30, DISTRHO_PLUGIN_NAME, 32, Color(240, 240, 250), ALIGN_LEFT | ALIGN_MIDDLE);
         txt(W - 25, 30, "v1.0", 16, Color(100, 100, 120), ALIGN_RIGHT | ALIGN_MIDDLE);
+#if FREQUENCYGATE_INSTRUMENTATION
+        {
+            // DSP load of this instance (output parameters)
+            char buf[64];
+            std::snprintf(buf, 64, "DSP %.1f%%  peak %.1f%%", fP[kParamDspLoad], fP[kParamDspPeak]);
+            txt(W - 80, 30, buf, 14, Color(120, 120, 140), ALIGN_RIGHT | ALIGN_MIDDLE);
+        }
+#endif
         
         float y = 80;
         
@@ -100,6 +119,28 @@ protected:
         
         y += 140;
         
+        // === AUTO THRESHOLD SECTION ===
+        txt(25, y, "Auto Threshold", 18, Color(255, 180, 100), ALIGN_LEFT | ALIGN_TOP);
+        y += 35;
+        
+        txt(25, y, "Track Noise Floor", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawDropdown(25, y + 25, 160, 40, kParamAutoThreshold, kOffOnNames, 2);
+        drawKnob(270, y + 45, "Margin", "dB", kParamAutoMargin, 0, 30, false);
+        
+        // Tracked floor readout (output parameter)
+        {
+            char buf[64];
+            std::snprintf(buf, 64, "Floor: %.1f dB", fP[kParamNoiseFloor]);
+            txt(360, y + 30, buf, 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_MIDDLE);
+            if (fP[kParamAutoThreshold] >= 0.5f) {
+                float open = std::max(-96.0f, std::min(0.0f, fP[kParamNoiseFloor] + fP[kParamAutoMargin]));
+                std::snprintf(buf, 64, "Opens at: %.1f dB", open);
+                txt(360, y + 60, buf, 16, Color(120, 200, 140), ALIGN_LEFT | ALIGN_MIDDLE);
+            }
+        }
+        
+        y += 140;
+        
         // === ENVELOPE SECTION ===
         txt(25, y, "Envelope", 18, Color(255, 180, 100), ALIGN_LEFT | ALIGN_TOP);
         y += 35;
@@ -116,11 +157,45 @@ protected:
         txt(25, y, "FFT Settings", 18, Color(255, 180, 100), ALIGN_LEFT | ALIGN_TOP);
         y += 35;
         
-        txt(25, y, "FFT Size (Latency)", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        txt(25, y, "FFT Window (Latency)", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
         drawDropdown(25, y + 25, 160, 40, kParamFFTSize, kFFTNames, kFFTSizeCount);
         
-        // Info
-        txt(220, y + 35, "2048 recommended for voice (~21ms latency)", 14, Color(120, 120, 140), ALIGN_LEFT | ALIGN_MIDDLE);
+        txt(210, y, "Gate Mode", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawDropdown(210, y + 25, 160, 40, kParamGateMode, kGateModeNames, kGateModeCount);
+        
+        // Band averaging across hops (0 = off): steadies short windows
+        txt(395, y, "Averaging", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawNumBox(395, y + 25, 160, 40, kParamAveraging, 0, MAX_AVERAGING_MS, false, "ms");
+        
+        y += 85;
+        
+        // === ROUTING SECTION ===
+        txt(25, y, "Routing", 18, Color(255, 180, 100), ALIGN_LEFT | ALIGN_TOP);
+        y += 35;
+        
+        txt(25, y, "Key Source", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawDropdown(25, y + 25, 160, 40, kParamKeySource, kKeySourceNames, kKeySourceCount);
+        
+        txt(210, y, "Share Group", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawDropdown(210, y + 25, 160, 40, kParamShareGroup, kShareGroupNames, kShareGroupCount);
+        
+        // Per-channel detection keeps out-of-phase or panned content from cancelling in the mix
+        txt(395, y, "Channel Detect", 16, Color(200, 200, 220), ALIGN_LEFT | ALIGN_TOP);
+        drawDropdown(395, y + 25, 160, 40, kParamChannelDetect, kChannelDetectNames, kChannelDetectCount);
+        txt(580, y + 45, "Same group = one detector", 14, Color(120, 120, 140), ALIGN_LEFT | ALIGN_MIDDLE);
+        
+        y += 85;
+        
+        // === DETECTION MIX SECTION ===
+        txt(25, y, "Detection Mix", 18, Color(255, 180, 100), ALIGN_LEFT | ALIGN_TOP);
+        txt(W - 25, y + 4, "Channel weights (main key)", 14, Color(120, 120, 140), ALIGN_RIGHT | ALIGN_TOP);
+        y += 35;
+        
+        const int nch = FREQUENCYGATE_NUM_CHANNELS;
+        const float gap = 8;
+        const float bw = std::min(60.0f, (W - 50 - gap * (nch - 1)) / nch);
+        for (int c = 0; c < nch; c++)
+            drawWeight(25 + c * (bw + gap), y, bw, 60, kParamChannelWeight0 + c, getChannelLabel(c));
     }
 
     void txt(float x, float y, const char* s, float sz, Color c, int a) {
@@ -202,6 +277,25 @@ protected:
         txt(cx, cy + R + 32, unit, 13, Color(120, 120, 140), ALIGN_CENTER | ALIGN_TOP);
     }
 
+    void drawWeight(float x, float y, float w, float h, int p, const char* lbl) {
+        mA[p] = {x, y, w, h};
+        float norm = std::max(0.0f, std::min(1.0f, fP[p]));
+        
+        beginPath(); roundedRect(x, y, w, h, 4);
+        fillColor(15, 15, 22); fill();
+        if (norm > 0.01f) {
+            beginPath(); roundedRect(x + 3, y + 3 + (h - 6) * (1.0f - norm), w - 6, (h - 6) * norm, 3);
+            fillColor(60, 100, 160); fill();
+        }
+        beginPath(); roundedRect(x, y, w, h, 4);
+        strokeColor(80, 80, 100); strokeWidth(1.5f); stroke();
+        
+        char buf[16];
+        std::snprintf(buf, 16, "%.2f", fP[p]);
+        txt(x + w/2, y + h/2, buf, 12, Color(220, 220, 240), ALIGN_CENTER | ALIGN_MIDDLE);
+        txt(x + w/2, y + h + 8, lbl, 13, Color(200, 200, 220), ALIGN_CENTER | ALIGN_TOP);
+    }
+
     void drawDropdown(float x, float y, float w, float h, int p, const char* const* names, int cnt) {
         mA[p] = {x, y, w, h};
         
@@ -239,6 +333,26 @@ protected:
                         int nv = (static_cast<int>(fP[i]) + 1) % kFFTSizeCount;
                         fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
                     }
+                    if (i == kParamGateMode) {
+                        int nv = (static_cast<int>(fP[i]) + 1) % kGateModeCount;
+                        fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                    }
+                    if (i == kParamAutoThreshold) {
+                        int nv = fP[i] >= 0.5f ? 0 : 1;
+                        fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                    }
+                    if (i == kParamShareGroup) {
+                        int nv = (static_cast<int>(fP[i]) + 1) % kShareGroupCount;
+                        fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                    }
+                    if (i == kParamKeySource) {
+                        int nv = (static_cast<int>(fP[i]) + 1) % kKeySourceCount;
+                        fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                    }
+                    if (i == kParamChannelDetect) {
+                        int nv = (static_cast<int>(fP[i]) + 1) % kChannelDetectCount;
+                        fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                    }
                     
                     mDragging = i; mDragY = ev.pos.getY(); mDragVal = fP[i];
                     return true;
@@ -260,7 +374,11 @@ protected:
             case kParamHold: mn = 0; mx = 500; break;
             case kParamRelease: mn = 1; mx = 1000; lg = true; break;
             case kParamHysteresis: mn = 0; mx = 12; break;
-            default: return false;
+            case kParamAutoMargin: mn = 0; mx = 30; break;
+            case kParamAveraging: mn = 0; mx = MAX_AVERAGING_MS; break;
+            default:
+                if (mDragging >= kParamChannelWeight0 && mDragging < kParamCount) { mn = 0; mx = 1; break; }
+                return false;
         }
         
         float dy = mDragY - ev.pos.getY();
@@ -298,6 +416,30 @@ protected:
                     nv = std::max(0, std::min(kFFTSizeCount - 1, nv));
                     fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
                 }
+                if (i == kParamGateMode) {
+                    int nv = static_cast<int>(fP[i]) + (ev.delta.getY() > 0 ? -1 : 1);
+                    nv = std::max(0, std::min(kGateModeCount - 1, nv));
+                    fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                }
+                if (i == kParamAutoThreshold) {
+                    int nv = ev.delta.getY() > 0 ? 0 : 1;
+                    fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                }
+                if (i == kParamShareGroup) {
+                    int nv = static_cast<int>(fP[i]) + (ev.delta.getY() > 0 ? -1 : 1);
+                    nv = std::max(0, std::min(kShareGroupCount - 1, nv));
+                    fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                }
+                if (i == kParamKeySource) {
+                    int nv = static_cast<int>(fP[i]) + (ev.delta.getY() > 0 ? -1 : 1);
+                    nv = std::max(0, std::min(kKeySourceCount - 1, nv));
+                    fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                }
+                if (i == kParamChannelDetect) {
+                    int nv = static_cast<int>(fP[i]) + (ev.delta.getY() > 0 ? -1 : 1);
+                    nv = std::max(0, std::min(kChannelDetectCount - 1, nv));
+                    fP[i] = nv; setParameterValue(i, nv); repaint(); return true;
+                }
                 
                 float mn, mx; bool lg = false;
                 switch (i) {
@@ -308,7 +450,11 @@ protected:
                     case kParamHold: mn = 0; mx = 500; break;
                     case kParamRelease: mn = 1; mx = 1000; lg = true; break;
                     case kParamHysteresis: mn = 0; mx = 12; break;
-                    default: return false;
+                    case kParamAutoMargin: mn = 0; mx = 30; break;
+                    case kParamAveraging: mn = 0; mx = MAX_AVERAGING_MS; break;
+                    default:
+                        if (i >= kParamChannelWeight0 && i < kParamCount) { mn = 0; mx = 1; break; }
+                        return false;
                 }
                 
                 float nv;
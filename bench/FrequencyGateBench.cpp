@@ -0,0 +1,290 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Benchmark and CPU budgets
+ *
+ *   frequencygate-bench                                   print the cost table
+ *   frequencygate-bench --check bench/budgets.txt         fail if a configuration is over budget
+ *   frequencygate-bench --write-budgets <file> [--headroom 3]
+ *
+ * Each configuration gates the voice fixture in 256-frame blocks (a typical host
+ * buffer) and reports the best of several runs as a percentage of one core at 48 kHz.
+ * Spectral configurations also report their cost relative to the broadband path at
+ * the same FFT size. The @rate cases run the default window at other sample rates: the
+ * window stays fixed in ms, so N doubles with the rate and the cost per second of audio
+ * grows at least linearly with it (the FFT a little more, by log N). The event_log case
+ * adds the gate event recorder (writing to a temporary file) to show its audio-thread cost.
+ *
+ * The table runs the instruction set the engine picks for this CPU. It is followed by the
+ * broadband and spectral cases at every FFT size for each instruction set variant the
+ * CPU supports, with the speedup over the baseline build, and by the worst single
+ * callback for many instances run one after another, as a host does, with all hops
+ * aligned and with staggered hop phases (--instances, --callback). Neither is budgeted:
+ * they depend on the machine more than on the code.
+ */
+
+#include "FrequencyGateFixtures.hpp"
+#include "FrequencyGateHopPhase.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace FrequencyGateFixtures;
+
+struct BenchCase {
+    std::string name;
+    int channels;
+    Config config;
+    std::string baseline;   // Broadband case to compare against (spectral cases)
+    double rate = kSampleRate;
+    bool events = false;    // Attach a gate event recorder
+};
+
+static std::vector<BenchCase> makeCases()
+{
+    std::vector<BenchCase> cases;
+    for (int fft = 0; fft < kFFTSizeCount; fft++) {
+        const std::string prefix = "fft" + std::to_string(getFFTSizeFromOption(fft));
+        const std::pair<uint32_t, float> size = { kParamFFTSize, static_cast<float>(fft) };
+        cases.push_back({ prefix + "/broadband", 2, { "", { size } }, "" });
+        cases.push_back({ prefix + "/spectral", 2, { "", { size, { kParamGateMode, kGateSpectral } } }, prefix + "/broadband" });
+    }
+    for (int method = 1; method < kDetectCount; method++)
+        cases.push_back({ std::string("fft2048/") + detectionName(method), 2,
+                          { "", { { kParamDetectionMethod, static_cast<float>(method) } } }, "fft2048/broadband" });
+    cases.push_back({ "fft2048/auto_threshold", 2, { "", { { kParamAutoThreshold, 1.0f } } }, "fft2048/broadband" });
+    cases.push_back({ "fft2048/preopen", 2, { "", { { kParamPreOpen, 10.0f } } }, "fft2048/broadband" });
+    cases.push_back({ "fft512/averaged", 2, { "", { { kParamFFTSize, kFFTSize512 }, { kParamAveraging, 40.0f } } },
+                      "fft512/broadband" });
+    cases.push_back({ "fft2048/event_log", 2, { "", {} }, "fft2048/broadband", kSampleRate, true });
+    cases.push_back({ "fft2048/channel_max", 2, { "", { { kParamChannelDetect, kChannelMax } } }, "fft2048/broadband" });
+    cases.push_back({ "8ch/broadband", 8, { "", {} }, "" });
+    cases.push_back({ "8ch/spectral", 8, { "", { { kParamGateMode, kGateSpectral } } }, "8ch/broadband" });
+    cases.push_back({ "8ch/channel_max", 8, { "", { { kParamChannelDetect, kChannelMax } } }, "8ch/broadband" });
+    for (double rate : { 44100.0, 96000.0, 192000.0 }) {
+        const std::string suffix = "@" + std::to_string(static_cast<int>(rate / 1000.0)) + "k";
+        cases.push_back({ "fft2048/broadband" + suffix, 2, { "", {} }, "", rate });
+        cases.push_back({ "fft2048/spectral" + suffix, 2, { "", { { kParamGateMode, kGateSpectral } } },
+                          "fft2048/broadband" + suffix, rate });
+    }
+    return cases;
+}
+
+// Best-of-N processing time as a percentage of one core
+static double measure(const Fixture& fixture, const Config& config, bool events, int repeat, uint32_t block,
+                      FrequencyGateSimd::Level simd = FrequencyGateSimd::kAuto)
+{
+    const std::string eventPath = (std::filesystem::temp_directory_path() / "frequencygate-bench-events.bin").string();
+    const uint64_t frames = fixture.frames();
+    std::vector<float> output(fixture.samples.size());
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        FrequencyGateDSP dsp(fixture.channels, simd);
+        GateEventRecorder recorder;
+        if (events && recorder.open(eventPath)) dsp.setEventRing(&recorder.ring());
+        configure(dsp, fixture, config);
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t pos = 0; pos < frames; pos += block) {
+            const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, frames - pos));
+            for (int c = 0; c < fixture.channels; c++) {
+                in[c] = fixture.channel(c) + pos;
+                out[c] = &output[c * frames + pos];
+            }
+            dsp.process(in.data(), out.data(), count);
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    if (events) std::filesystem::remove(eventPath);
+    return 100.0 * best / (frames / fixture.sampleRate);
+}
+
+// Worst and mean time (us) of one host callback running every instance, best of N runs
+static void measureCallbacks(const Fixture& fixture, int instances, bool stagger, int repeat, uint32_t block,
+                             double& worstUs, double& meanUs)
+{
+    const uint64_t frames = std::min<uint64_t>(fixture.frames(), static_cast<uint64_t>(2.0 * fixture.sampleRate));
+    std::vector<float> output(fixture.channels * block);
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    for (int c = 0; c < fixture.channels; c++) out[c] = &output[c * block];
+    worstUs = meanUs = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        std::vector<std::unique_ptr<FrequencyGateDSP>> gates;
+        for (int i = 0; i < instances; i++) {
+            gates.emplace_back(new FrequencyGateDSP(fixture.channels));
+            gates.back()->setHopPhase(stagger ? HopPhase::fromIndex(i) : 0.0f);
+            configure(*gates.back(), fixture, { "", {} });
+        }
+        double worst = 0.0, total = 0.0;
+        uint64_t callbacks = 0;
+        for (uint64_t pos = 0; pos + block <= frames; pos += block) {
+            for (int c = 0; c < fixture.channels; c++) in[c] = fixture.channel(c) + pos;
+            const auto start = std::chrono::steady_clock::now();
+            for (auto& gate : gates) gate->process(in.data(), out.data(), block);
+            const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            worst = std::max(worst, us);
+            total += us;
+            callbacks++;
+        }
+        worstUs = std::min(worstUs, worst);
+        meanUs = std::min(meanUs, total / std::max<uint64_t>(1, callbacks));
+    }
+}
+
+static bool loadBudgets(const std::string& path, std::map<std::string, double>& budgets)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        double percent;
+        if (fields >> name >> percent) budgets[name] = percent;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string checkPath, writePath;
+    double headroom = 3.0;
+    double seconds = 10.0;
+    int repeat = 3;
+    uint32_t block = 256;
+    int instances = 40;
+    uint32_t callback = 64;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--check" && hasValue) checkPath = argv[++i];
+        else if (arg == "--write-budgets" && hasValue) writePath = argv[++i];
+        else if (arg == "--headroom" && hasValue) headroom = std::atof(argv[++i]);
+        else if (arg == "--seconds" && hasValue) seconds = std::atof(argv[++i]);
+        else if (arg == "--repeat" && hasValue) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--block" && hasValue) block = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--instances" && hasValue) instances = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--callback" && hasValue) callback = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else {
+            std::printf("Usage: frequencygate-bench [--check <budgets>] [--write-budgets <file> [--headroom <x>]]\n"
+                        "                           [--seconds <s>] [--repeat <n>] [--block <frames>]\n"
+                        "                           [--instances <n>] [--callback <frames>]\n");
+            return 1;
+        }
+    }
+
+#ifndef NDEBUG
+    // Budgets are for optimized builds; an unoptimized run would only report noise
+    if (!checkPath.empty()) {
+        std::printf("cpu budgets skipped: build with optimizations (Release) to check them\n");
+        return 77;
+    }
+#endif
+
+    std::map<std::string, double> budgets;
+    if (!checkPath.empty() && !loadBudgets(checkPath, budgets)) {
+        std::printf("cannot read %s\n", checkPath.c_str());
+        return 1;
+    }
+
+    const Fixture surround = makeVoice(8, seconds);
+    std::map<double, Fixture> stereo;
+    for (const BenchCase& bench : makeCases())
+        if (bench.channels == 2 && !stereo.count(bench.rate)) stereo[bench.rate] = makeVoice(2, seconds, bench.rate);
+    std::map<std::string, double> results;
+    int failures = 0;
+
+    std::printf("instruction set: %s\n", FrequencyGateSimd::levelName(FrequencyGateSimd::select()));
+    std::printf("%-24s %8s %12s %14s %8s\n", "configuration", "% core", "x realtime", "vs broadband", "budget");
+    for (const BenchCase& bench : makeCases()) {
+        if (!budgets.empty() && !budgets.count(bench.name)) continue;
+        const double percent = measure(bench.channels == 8 ? surround : stereo[bench.rate], bench.config, bench.events,
+                                       repeat, block);
+        results[bench.name] = percent;
+
+        char relative[32] = "";
+        if (!bench.baseline.empty() && results.count(bench.baseline))
+            std::snprintf(relative, sizeof(relative), "%.2fx", percent / results[bench.baseline]);
+        char budget[32] = "";
+        if (budgets.count(bench.name)) {
+            const bool over = percent > budgets[bench.name];
+            std::snprintf(budget, sizeof(budget), "%.2f%s", budgets[bench.name], over ? " OVER" : "");
+            failures += over ? 1 : 0;
+        }
+        std::printf("%-24s %8.3f %12.1f %14s %8s\n", bench.name.c_str(), percent, 100.0 / percent, relative, budget);
+    }
+    for (const auto& budget : budgets) {
+        if (!results.count(budget.first)) {
+            std::printf("budget for unknown configuration %s\n", budget.first.c_str());
+            failures++;
+        }
+    }
+
+    // Same work on every instruction set variant this CPU runs: % of one core, speedup over the baseline
+    if (checkPath.empty()) {
+        std::vector<FrequencyGateSimd::Level> levels;
+        for (int k = FrequencyGateSimd::kBaseline; k < FrequencyGateSimd::kLevelCount; k++)
+            if (FrequencyGateSimd::supported(static_cast<FrequencyGateSimd::Level>(k)))
+                levels.push_back(static_cast<FrequencyGateSimd::Level>(k));
+        std::printf("\n%-24s", "instruction set");
+        for (FrequencyGateSimd::Level level : levels) std::printf(" %16s", FrequencyGateSimd::levelName(level));
+        std::printf("\n");
+        for (const BenchCase& bench : makeCases()) {
+            if (bench.name.compare(0, 3, "fft") != 0 || bench.name.find('@') != std::string::npos
+                || (bench.name.find("/broadband") == std::string::npos && bench.name.find("/spectral") == std::string::npos))
+                continue;
+            std::printf("%-24s", bench.name.c_str());
+            double baseline = 0.0;
+            for (FrequencyGateSimd::Level level : levels) {
+                const double percent = measure(stereo[bench.rate], bench.config, false, repeat, block, level);
+                if (level == FrequencyGateSimd::kBaseline) baseline = percent;
+                std::printf(" %8.3f %6.2fx", percent, baseline / percent);
+            }
+            std::printf("\n");
+        }
+    }
+
+    // Many instances in one session: the callback that runs every FFT at once sets the peak
+    if (checkPath.empty() && instances > 0) {
+        double alignedWorst, alignedMean, staggeredWorst, staggeredMean;
+        measureCallbacks(stereo[kSampleRate], instances, false, repeat, callback, alignedWorst, alignedMean);
+        measureCallbacks(stereo[kSampleRate], instances, true, repeat, callback, staggeredWorst, staggeredMean);
+        std::printf("\n%d instances, %u-frame callbacks (%.0f us of audio at 48 kHz)\n", instances, callback,
+                    1e6 * callback / kSampleRate);
+        std::printf("%-24s %10s %10s\n", "hop phases", "worst us", "mean us");
+        std::printf("%-24s %10.1f %10.1f\n", "aligned", alignedWorst, alignedMean);
+        std::printf("%-24s %10.1f %10.1f\n", "staggered", staggeredWorst, staggeredMean);
+    }
+
+    if (!writePath.empty()) {
+        std::FILE* file = std::fopen(writePath.c_str(), "w");
+        if (!file) {
+            std::printf("cannot write %s\n", writePath.c_str());
+            return 1;
+        }
+        std::fprintf(file, "# CPU budgets: %% of one core (48 kHz stereo unless named @rate / 8ch), release build.\n");
+        std::fprintf(file, "# Checked by ctest (cpu_budgets). Measured on this machine x %.1f headroom by\n", headroom);
+        std::fprintf(file, "#   frequencygate-bench --write-budgets\n");
+        for (const BenchCase& bench : makeCases()) {
+            const double budget = std::max(0.1, std::ceil(results[bench.name] * headroom * 10.0) / 10.0);
+            std::fprintf(file, "%-24s %.1f\n", bench.name.c_str(), budget);
+        }
+        std::fclose(file);
+        std::printf("wrote %s\n", writePath.c_str());
+    }
+
+    if (failures) std::printf("%d configuration(s) over budget\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Capture replay
+ *
+ *   frequencygate-replay <capture.fgcap>                 replay and report differences
+ *   frequencygate-replay <capture.fgcap> --check         fail on any difference
+ *   frequencygate-replay <capture.fgcap> --simd avx2 --repeat 5
+ *
+ * Feeds a session captured by the plugin (FREQUENCYGATE_CAPTURE, see FrequencyGateCapture.hpp)
+ * through a new engine with the captured block sizes, parameter changes and activations,
+ * as fast as it goes. Reports the processing time (best of --repeat runs) and where the
+ * output and the gate decisions differ from the captured ones, so an optimization can be
+ * profiled and checked against real traffic. By default the replay runs the instruction
+ * set the capture ran; --simd picks another (auto: the widest this CPU supports).
+ */
+
+#include "FrequencyGateCapture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    std::string path, simdName;
+    bool check = false;
+    int repeat = 1;
+    double tolerance = 1e-5;   // -100 dBFS: rounding differences between instruction sets stay below
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--check") check = true;
+        else if (arg == "--simd" && hasValue) simdName = argv[++i];
+        else if (arg == "--repeat" && hasValue) repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--tolerance" && hasValue) tolerance = std::max(0.0, std::atof(argv[++i]));
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::printf("Usage: frequencygate-replay <capture> [--check] [--simd auto|sse2|avx2|avx512]\n"
+                    "                            [--repeat <n>] [--tolerance <linear>]\n");
+        return 1;
+    }
+
+    GateCaptureReader reader;
+    if (!reader.open(path)) {
+        std::printf("cannot read %s (not a capture?)\n", path.c_str());
+        return 1;
+    }
+
+    // Instruction set: as captured, unless asked otherwise or not available here
+    if (simdName.empty()) simdName = reader.simdName();
+    FrequencyGateSimd::Level level = FrequencyGateSimd::kAuto;
+    for (int k = FrequencyGateSimd::kBaseline; k < FrequencyGateSimd::kLevelCount; k++)
+        if (simdName == FrequencyGateSimd::levelName(static_cast<FrequencyGateSimd::Level>(k)))
+            level = static_cast<FrequencyGateSimd::Level>(k);
+    if (level != FrequencyGateSimd::kAuto && !FrequencyGateSimd::supported(level))
+        std::printf("%s is not available on this CPU or build: replaying on the widest supported set\n", simdName.c_str());
+    const char* replayedOn = FrequencyGateSimd::backend(level).name;
+
+    ReplayResult result = replayCapture(reader, level, tolerance);
+    for (int r = 1; r < repeat; r++) {
+        // Later runs only time; the differences are those of the first
+        GateCaptureReader again;
+        again.open(path);
+        const ReplayResult run = replayCapture(again, level, tolerance);
+        result.processSeconds = std::min(result.processSeconds, run.processSeconds);
+        result.worstBlockUs = std::min(result.worstBlockUs, run.worstBlockUs);
+    }
+
+    std::printf("%s: %d channel(s), %d input(s), captured on %s, replayed on %s\n", path.c_str(), reader.channels(),
+                reader.inputs(), reader.simdName(), replayedOn);
+    std::printf("%llu blocks of %u..%u frames, %.1f s of audio, %llu activation(s), %llu parameter change(s)\n",
+                static_cast<unsigned long long>(result.blocks), result.minBlock, result.maxBlock, result.audioSeconds,
+                static_cast<unsigned long long>(result.activations),
+                static_cast<unsigned long long>(result.parameterChanges));
+    if (result.lostFrames)
+        std::printf("capture dropped %llu input frames (ring full): differences after the first gap are expected\n",
+                    static_cast<unsigned long long>(result.lostFrames));
+    std::printf("process: %.3f s%s, x%.1f realtime, worst block %.1f us\n", result.processSeconds,
+                repeat > 1 ? " (best run)" : "", result.processSeconds > 0.0 ? result.audioSeconds / result.processSeconds : 0.0,
+                result.worstBlockUs);
+    if (result.maxOutputDiff > 0.0)
+        std::printf("output: max difference %.3g (%.1f dBFS), %llu of %llu blocks over %.3g", result.maxOutputDiff,
+                    20.0 * std::log10(result.maxOutputDiff), static_cast<unsigned long long>(result.outputDiffBlocks),
+                    static_cast<unsigned long long>(result.comparedBlocks), tolerance);
+    else
+        std::printf("output: identical in %llu blocks", static_cast<unsigned long long>(result.comparedBlocks));
+    if (result.outputDiffBlocks) std::printf(", first at %.3f s", result.firstOutputDiffSeconds);
+    std::printf("\ngate decisions: %llu block(s) differ", static_cast<unsigned long long>(result.decisionDiffs));
+    if (result.decisionDiffs) std::printf(", first at %.3f s", result.firstDecisionDiffSeconds);
+    std::printf("\n");
+
+    const bool differs = result.outputDiffBlocks || result.decisionDiffs;
+    return check && differs ? 1 : 0;
+}
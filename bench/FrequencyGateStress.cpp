@@ -0,0 +1,268 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Real-time stress test
+ *
+ *   frequencygate-stress                                    print block time statistics
+ *   frequencygate-stress --check bench/stress_budgets.txt   fail if a budget is exceeded
+ *
+ * An audio thread gates the voice fixture in small blocks at real-time pace while an
+ * automation thread keeps setting random values on every parameter, as a host does from
+ * automation lanes: FFT size and gate mode changes (which rebuild the analysis), Pre-Open
+ * and band changes, detector switches, share groups. Averages hide what causes dropouts,
+ * so this reports the worst and the 99.9th percentile block time as a percentage of the
+ * block's duration, and counts every heap allocation made on the audio thread.
+ * Allocations are checked in every build; block times only in optimized builds.
+ */
+
+#include "FrequencyGateFixtures.hpp"
+#include "FrequencyGatePresets.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace FrequencyGateFixtures;
+
+// Heap allocations made while the audio thread is inside process()
+static std::atomic<uint64_t> gAudioAllocations{0};
+static thread_local bool tCountAllocations = false;
+
+static inline void countAllocation()
+{
+    if (tCountAllocations) gAudioAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+// glibc: intercept the C allocator itself, which also covers operator new and the
+// engine's aligned buffers
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) { countAllocation(); return __libc_malloc(size); }
+void* calloc(size_t count, size_t size) { countAllocation(); return __libc_calloc(count, size); }
+void* realloc(void* ptr, size_t size) { countAllocation(); return __libc_realloc(ptr, size); }
+void* aligned_alloc(size_t alignment, size_t size) { countAllocation(); return __libc_memalign(alignment, size); }
+void* memalign(size_t alignment, size_t size) { countAllocation(); return __libc_memalign(alignment, size); }
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    countAllocation();
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : 12;   // ENOMEM
+}
+}
+#else
+// Elsewhere: operator new only
+void* operator new(size_t size)
+{
+    countAllocation();
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+#endif
+
+struct StressOptions {
+    double seconds = 5.0;
+    uint32_t block = 64;
+    int channels = 2;
+    double changesPerSecond = 2000.0;
+    unsigned seed = 1;
+};
+
+struct StressResult {
+    std::vector<double> blockUs;    // Time of every block
+    uint64_t allocations = 0;
+    uint64_t changes = 0;
+    bool realtime = false;          // Audio thread got a real-time priority
+};
+
+// Parameters the host can automate, with their ranges
+static std::vector<FrequencyGatePresets::ParamSpec> automatedParams(int channels)
+{
+    std::vector<FrequencyGatePresets::ParamSpec> specs(std::begin(FrequencyGatePresets::kParamSpecs),
+                                                       std::end(FrequencyGatePresets::kParamSpecs));
+    specs.push_back({ "share_group", kParamShareGroup, 0.0f, MAX_SHARE_GROUPS });
+    specs.push_back({ "key_source", kParamKeySource, 0.0f, kKeySourceCount - 1 });
+    for (int c = 0; c < channels; c++)
+        specs.push_back({ "detect_weight", static_cast<uint32_t>(kParamChannelWeight0 + c), 0.0f, 1.0f });
+    return specs;
+}
+
+static bool raisePriority()
+{
+#ifndef _WIN32
+    sched_param param;
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+    return false;
+#endif
+}
+
+static StressResult runStress(const Fixture& fixture, const StressOptions& opt)
+{
+    StressResult result;
+    FrequencyGateDSP dsp(fixture.channels);
+    configure(dsp, fixture, { "", {} });
+
+    const uint64_t blocks = static_cast<uint64_t>(opt.seconds * fixture.sampleRate / opt.block);
+    result.blockUs.assign(blocks, 0.0);
+    std::vector<float> output(fixture.channels * opt.block);
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    for (int c = 0; c < fixture.channels; c++) out[c] = &output[c * opt.block];
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> changes{0};
+    std::thread automation([&] {
+        const std::vector<FrequencyGatePresets::ParamSpec> specs = automatedParams(fixture.channels);
+        std::mt19937 rng(opt.seed);
+        std::uniform_int_distribution<size_t> pick(0, specs.size() - 1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const auto interval = std::chrono::duration<double>(1.0 / opt.changesPerSecond);
+        auto next = std::chrono::steady_clock::now();
+        while (!done.load(std::memory_order_relaxed)) {
+            const FrequencyGatePresets::ParamSpec& spec = specs[pick(rng)];
+            dsp.setParameter(spec.index, spec.min + (spec.max - spec.min) * unit(rng));
+            changes.fetch_add(1, std::memory_order_relaxed);
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::thread audio([&] {
+        result.realtime = raisePriority();
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(opt.block / fixture.sampleRate));
+        const uint64_t fixtureBlocks = fixture.frames() / opt.block;
+        auto next = std::chrono::steady_clock::now();
+        for (uint64_t b = 0; b < blocks; b++) {
+            const uint64_t pos = (b % fixtureBlocks) * opt.block;
+            for (int c = 0; c < fixture.channels; c++) in[c] = fixture.channel(c) + pos;
+            tCountAllocations = true;
+            const auto start = std::chrono::steady_clock::now();
+            dsp.process(in.data(), out.data(), opt.block);
+            const auto end = std::chrono::steady_clock::now();
+            tCountAllocations = false;
+            result.blockUs[b] = std::chrono::duration<double, std::micro>(end - start).count();
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    audio.join();
+    done = true;
+    automation.join();
+    result.allocations = gAudioAllocations.load();
+    result.changes = changes.load();
+    return result;
+}
+
+static bool loadBudgets(const std::string& path, std::map<std::string, double>& budgets)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        double value;
+        if (fields >> name >> value) budgets[name] = value;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string checkPath;
+    StressOptions opt;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--check" && hasValue) checkPath = argv[++i];
+        else if (arg == "--seconds" && hasValue) opt.seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (arg == "--block" && hasValue) opt.block = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--channels" && hasValue) opt.channels = std::max(1, std::min(MAX_CHANNELS, std::atoi(argv[++i])));
+        else if (arg == "--rate" && hasValue) opt.changesPerSecond = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        else {
+            std::printf("Usage: frequencygate-stress [--check <budgets>] [--seconds <s>] [--block <frames>]\n"
+                        "                            [--channels <n>] [--rate <changes/s>] [--seed <n>]\n");
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> budgets;
+    if (!checkPath.empty() && !loadBudgets(checkPath, budgets)) {
+        std::printf("cannot read %s\n", checkPath.c_str());
+        return 1;
+    }
+
+    const Fixture voice = makeVoice(opt.channels);
+    const StressResult result = runStress(voice, opt);
+
+    std::vector<double> sorted = result.blockUs;
+    std::sort(sorted.begin(), sorted.end());
+    const double blockUs = 1e6 * opt.block / voice.sampleRate;
+    const double maxPercent = 100.0 * sorted.back() / blockUs;
+    const double p999Percent = 100.0 * sorted[std::min(sorted.size() - 1, sorted.size() * 999 / 1000)] / blockUs;
+    double total = 0.0;
+    for (double us : sorted) total += us;
+
+    std::printf("%u-frame blocks (%.0f us) for %.1f s, %d channel(s), %llu parameter changes, %s priority\n",
+                opt.block, blockUs, opt.seconds, opt.channels, static_cast<unsigned long long>(result.changes),
+                result.realtime ? "real-time" : "normal");
+    std::printf("block time: mean %.1f us, p99.9 %.1f us (%.1f%%), max %.1f us (%.1f%%)\n",
+                total / sorted.size(), p999Percent * blockUs / 100.0, p999Percent, sorted.back(), maxPercent);
+    std::printf("audio thread allocations: %llu\n", static_cast<unsigned long long>(result.allocations));
+
+    const std::map<std::string, double> measured = {
+        { "block_max_percent", maxPercent },
+        { "block_p999_percent", p999Percent },
+        { "audio_allocations", static_cast<double>(result.allocations) },
+    };
+    int failures = 0;
+    for (const auto& budget : budgets) {
+        if (!measured.count(budget.first)) {
+            std::printf("unknown budget %s\n", budget.first.c_str());
+            failures++;
+            continue;
+        }
+#ifndef NDEBUG
+        // Block times are for optimized builds; an unoptimized run would only report noise
+        if (budget.first != "audio_allocations") {
+            std::printf("%s skipped: build with optimizations (Release) to check it\n", budget.first.c_str());
+            continue;
+        }
+#endif
+        if (measured.at(budget.first) > budget.second) {
+            std::printf("%s %.1f OVER budget %.1f\n", budget.first.c_str(), measured.at(budget.first), budget.second);
+            failures++;
+        }
+    }
+    if (failures) std::printf("%d budget(s) exceeded\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Test fixtures and configurations shared by the regression tests and the benchmark
+ *
+ * Fixtures are synthesized from a fixed seed with an in-house generator, so every
+ * platform renders the same input. Each run records the gate transitions (after every
+ * hop) and the output envelope (RMS per 20 ms window), which is what the golden files
+ * store.
+ */
+
+#ifndef FREQUENCY_GATE_FIXTURES_HPP_INCLUDED
+#define FREQUENCY_GATE_FIXTURES_HPP_INCLUDED
+
+#include "FrequencyGateDSP.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FrequencyGateFixtures {
+
+static const double kSampleRate = 48000.0;
+static const double kTwoPi = 6.283185307179586;
+static const double kEnvelopeWindowSeconds = 0.020;
+
+// ============================================================================
+// Signals
+// ============================================================================
+
+// xorshift32: identical sequence everywhere, unlike <random> distributions
+class Noise
+{
+public:
+    explicit Noise(uint32_t seed) : mState(seed ? seed : 1u) {}
+    float next()   // Uniform in [-1, 1)
+    {
+        mState ^= mState << 13;
+        mState ^= mState >> 17;
+        mState ^= mState << 5;
+        return static_cast<int32_t>(mState) * (1.0f / 2147483648.0f);
+    }
+private:
+    uint32_t mState;
+};
+
+struct Fixture {
+    std::string name;
+    int channels;
+    double sampleRate;
+    float threshold;              // Gate threshold (dB) that separates the fixture's loud and quiet parts
+    std::vector<float> samples;   // Planar: channels x frames
+    uint64_t frames() const { return samples.size() / channels; }
+    float* channel(int c) { return &samples[static_cast<size_t>(c) * frames()]; }
+    const float* channel(int c) const { return &samples[static_cast<size_t>(c) * frames()]; }
+};
+
+inline float dbToGain(double db) { return static_cast<float>(std::pow(10.0, db / 20.0)); }
+
+// Raised-cosine fade in/out so segment edges do not splatter across the spectrum
+inline double segmentEnvelope(double t, double start, double end, double fade)
+{
+    if (t < start || t >= end) return 0.0;
+    const double in = std::min(1.0, (t - start) / fade);
+    const double out = std::min(1.0, (end - t) / fade);
+    const double x = std::min(in, out);
+    return 0.5 - 0.5 * std::cos(x * kTwoPi * 0.5);
+}
+
+// Copy a mono signal to every channel with small per-channel level and noise differences
+inline Fixture spread(const std::string& name, float threshold, const std::vector<float>& mono, int channels,
+                      double sampleRate, uint32_t seed)
+{
+    Fixture fixture;
+    fixture.name = name;
+    fixture.channels = channels;
+    fixture.sampleRate = sampleRate;
+    fixture.threshold = threshold;
+    fixture.samples.resize(mono.size() * channels);
+    Noise noise(seed);
+    for (int c = 0; c < channels; c++) {
+        const float gain = 1.0f - 0.08f * c;
+        float* dst = fixture.channel(c);
+        for (size_t i = 0; i < mono.size(); i++) dst[i] = mono[i] * gain + 0.0003f * noise.next();
+    }
+    return fixture;
+}
+
+// In-band (300 Hz) and out-of-band (3 kHz) tones at several levels over a -60 dB floor
+inline Fixture makeTones(int channels = 2, double seconds = 3.0, double rate = kSampleRate)
+{
+    struct Tone { double start, end, freq, db; };
+    static const Tone tones[] = {
+        { 0.30, 0.90,  300.0, -12.0 },   // Clearly above threshold
+        { 1.10, 1.50, 3000.0, -12.0 },   // Loud but outside the detection band
+        { 1.70, 2.10,  300.0, -60.0 },   // In band, below threshold
+        { 2.30, 2.70,  300.0, -24.0 },   // In band, moderately above threshold
+    };
+    const size_t frames = static_cast<size_t>(seconds * rate);
+    std::vector<float> mono(frames);
+    Noise noise(11);
+    for (size_t i = 0; i < frames; i++) {
+        const double t = i / rate;
+        double v = 0.001 * noise.next();
+        for (const Tone& tone : tones)
+            v += dbToGain(tone.db) * segmentEnvelope(t, tone.start, tone.end, 0.005) * std::sin(kTwoPi * tone.freq * t);
+        mono[i] = static_cast<float>(v);
+    }
+    return spread("tones", -58.0f, mono, channels, rate, 12);
+}
+
+// White noise bursts of different lengths over a -70 dB floor
+inline Fixture makeBursts(int channels = 2, double seconds = 3.0, double rate = kSampleRate)
+{
+    struct Burst { double start, length, db; };
+    static const Burst bursts[] = {
+        { 0.20, 0.050, -18.0 }, { 0.45, 0.300, -18.0 }, { 1.00, 0.120, -45.0 },
+        { 1.40, 0.020, -12.0 }, { 1.70, 0.500, -24.0 }, { 2.50, 0.080, -15.0 },
+    };
+    const size_t frames = static_cast<size_t>(seconds * rate);
+    std::vector<float> mono(frames);
+    Noise noise(21);
+    for (size_t i = 0; i < frames; i++) {
+        const double t = i / rate;
+        double level = 0.0003;
+        for (const Burst& burst : bursts)
+            level += dbToGain(burst.db) * segmentEnvelope(t, burst.start, burst.start + burst.length, 0.002);
+        mono[i] = static_cast<float>(level * noise.next());
+    }
+    return spread("bursts", -62.0f, mono, channels, rate, 22);
+}
+
+// Recorded-style voice: gliding glottal harmonics through two formants, shaped into
+// syllables and words, over room noise and 50 Hz hum
+inline Fixture makeVoice(int channels = 2, double seconds = 3.0, double rate = kSampleRate)
+{
+    struct Syllable { double start, length, f0, db; };
+    static const Syllable syllables[] = {
+        { 0.25, 0.18, 120.0, -14.0 }, { 0.45, 0.22, 135.0, -12.0 }, { 0.70, 0.15, 115.0, -18.0 },
+        { 1.20, 0.25, 150.0, -12.0 }, { 1.48, 0.12, 140.0, -20.0 },
+        { 2.00, 0.20, 125.0, -16.0 }, { 2.24, 0.30, 110.0, -13.0 },
+    };
+    const size_t frames = static_cast<size_t>(seconds * rate);
+    std::vector<float> mono(frames);
+    Noise noise(31);
+    double phase = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        const double t = i / rate;
+        double v = 0.002 * noise.next() + 0.003 * std::sin(kTwoPi * 50.0 * t);
+        for (const Syllable& s : syllables) {
+            const double env = segmentEnvelope(t, s.start, s.start + s.length, 0.03);
+            if (env <= 0.0) continue;
+            const double progress = (t - s.start) / s.length;
+            const double f0 = s.f0 * (1.0 + 0.08 * progress) * (1.0 + 0.01 * std::sin(kTwoPi * 5.5 * t));
+            phase += kTwoPi * f0 / rate;
+            double voiced = 0.0;
+            for (int k = 1; k * f0 < 4000.0; k++) {
+                const double f = k * f0;
+                const double d1 = (f - 600.0) / 150.0;
+                const double d2 = (f - 1700.0) / 250.0;
+                const double formants = 1.0 / (1.0 + d1 * d1) + 0.5 / (1.0 + d2 * d2);
+                voiced += formants / k * std::sin(k * phase);
+            }
+            v += dbToGain(s.db) * env * (0.5 * voiced + 0.02 * noise.next());
+        }
+        mono[i] = static_cast<float>(v);
+    }
+    return spread("voice", -56.0f, mono, channels, rate, 32);
+}
+
+inline std::vector<Fixture> makeAllFixtures(int channels = 2)
+{
+    return { makeTones(channels), makeBursts(channels), makeVoice(channels) };
+}
+
+// ============================================================================
+// Configurations
+// ============================================================================
+
+struct Config {
+    std::string name;
+    std::vector<std::pair<uint32_t, float>> params;
+};
+
+inline const char* detectionName(int method)
+{
+    static const char* names[kDetectCount] = { "average", "peak", "median", "rms", "trimmed", "flatness", "harmonic" };
+    return names[method];
+}
+
+// Every FFT size x detection method at default settings, then the key parameter sets
+inline std::vector<Config> makeConfigs()
+{
+    std::vector<Config> configs;
+    for (int fft = 0; fft < kFFTSizeCount; fft++) {
+        for (int method = 0; method < kDetectCount; method++) {
+            Config config;
+            config.name = "fft" + std::to_string(getFFTSizeFromOption(fft)) + "/" + detectionName(method);
+            config.params = { { kParamFFTSize, static_cast<float>(fft) }, { kParamDetectionMethod, static_cast<float>(method) } };
+            configs.push_back(config);
+        }
+    }
+    configs.push_back({ "spectral", { { kParamGateMode, kGateSpectral } } });
+    configs.push_back({ "spectral/fft512", { { kParamGateMode, kGateSpectral }, { kParamFFTSize, kFFTSize512 } } });
+    configs.push_back({ "preopen_hold", { { kParamPreOpen, 5.0f }, { kParamHold, 150.0f } } });
+    configs.push_back({ "fast_envelope", { { kParamAttack, 0.5f }, { kParamHold, 0.0f }, { kParamRelease, 20.0f } } });
+    configs.push_back({ "hysteresis_range", { { kParamHysteresis, 9.0f }, { kParamRange, -20.0f } } });
+    configs.push_back({ "auto_threshold", { { kParamAutoThreshold, 1.0f }, { kParamAutoMargin, 12.0f } } });
+    configs.push_back({ "high_band", { { kParamFreqLow, 1000.0f }, { kParamFreqHigh, 5000.0f } } });
+    configs.push_back({ "left_only", { { kParamChannelWeight0 + 1, 0.0f } } });
+    configs.push_back({ "fft512/averaged", { { kParamFFTSize, kFFTSize512 }, { kParamAveraging, 40.0f } } });
+    configs.push_back({ "fft1024/median_averaged", { { kParamFFTSize, kFFTSize1024 }, { kParamDetectionMethod, kDetectMedian },
+                                                     { kParamAveraging, 40.0f } } });
+    configs.push_back({ "channel_max", { { kParamChannelDetect, kChannelMax } } });
+    configs.push_back({ "spectral/channel_linked", { { kParamGateMode, kGateSpectral }, { kParamChannelDetect, kChannelLinked } } });
+    return configs;
+}
+
+// ============================================================================
+// Runner
+// ============================================================================
+
+struct Transition {
+    bool open;
+    double ms;
+};
+
+struct RunResult {
+    std::vector<Transition> transitions;
+    std::vector<float> envelopeDb;       // Output RMS (all channels) per 20 ms window
+    std::vector<float> output;           // Planar, same layout as the fixture
+    uint32_t latency = 0;
+    int hopSize = 0;
+};
+
+inline void configure(FrequencyGateDSP& dsp, const Fixture& fixture, const Config& config)
+{
+    dsp.setSampleRate(fixture.sampleRate);
+    dsp.setParameter(kParamThreshold, fixture.threshold);
+    for (const auto& p : config.params) dsp.setParameter(p.first, p.second);
+    dsp.activate();
+}
+
+// Process in hop-sized blocks so the gate state can be sampled after every hop
+inline RunResult runFixture(const Fixture& fixture, const Config& config,
+                            FrequencyGateSimd::Level simd = FrequencyGateSimd::kAuto)
+{
+    RunResult result;
+    FrequencyGateDSP dsp(fixture.channels, simd);
+    configure(dsp, fixture, config);
+    result.latency = dsp.getLatency();
+    result.hopSize = dsp.getHopSize();
+
+    const uint64_t frames = fixture.frames();
+    result.output.assign(fixture.samples.size(), 0.0f);
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    bool open = dsp.isGateOpen();
+    for (uint64_t pos = 0; pos < frames; ) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(result.hopSize, frames - pos));
+        for (int c = 0; c < fixture.channels; c++) {
+            in[c] = fixture.channel(c) + pos;
+            out[c] = &result.output[c * frames + pos];
+        }
+        dsp.process(in.data(), out.data(), count);
+        pos += count;
+        if (dsp.isGateOpen() != open) {
+            open = dsp.isGateOpen();
+            result.transitions.push_back({ open, pos * 1000.0 / fixture.sampleRate });
+        }
+    }
+
+    const uint64_t window = static_cast<uint64_t>(kEnvelopeWindowSeconds * fixture.sampleRate);
+    for (uint64_t start = 0; start + window <= frames; start += window) {
+        double power = 0.0;
+        for (int c = 0; c < fixture.channels; c++) {
+            const float* x = &result.output[c * frames + start];
+            for (uint64_t i = 0; i < window; i++) power += static_cast<double>(x[i]) * x[i];
+        }
+        power /= static_cast<double>(window) * fixture.channels;
+        result.envelopeDb.push_back(static_cast<float>(std::max(-120.0, 10.0 * std::log10(power + 1e-30))));
+    }
+    return result;
+}
+
+} // namespace FrequencyGateFixtures
+
+#endif // FREQUENCY_GATE_FIXTURES_HPP_INCLUDED
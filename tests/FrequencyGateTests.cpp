@@ -0,0 +1,933 @@
+/*
+ * FrequencyGate - Frequency-selective noise gate
+ * Regression tests
+ *
+ *   frequencygate-tests <golden dir>                   run everything
+ *   frequencygate-tests <golden dir> --update-golden   rewrite the golden files
+ *
+ * Golden checks run every fixture through every configuration and compare against
+ * tests/golden/<fixture>.txt. Transitions must match in count and direction and land
+ * within two hops of the stored time. Envelope windows must agree within 1 dB, except
+ * around a transition, where one hop of timing jitter moves a lot of energy. Invariant
+ * checks (block size, latency, split analysis, linked channels, share groups, event log,
+ * capture replay) must be exact, per-channel detection levels within 0.01 dB of the
+ * separately analyzed channels; the hop phase check allows the one hop its decisions may
+ * move by, and the envelope must stay within 1e-5 of the per-sample recursion. Averaging
+ * must at least halve the hop-to-hop level change on stationary noise. Every instruction
+ * set variant the CPU supports must match the baseline build within a hop and 0.05 dB.
+ */
+
+#include "FrequencyGateFixtures.hpp"
+#include "FrequencyGateCapture.hpp"
+#include "FrequencyGateHopPhase.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace FrequencyGateFixtures;
+
+static const double kEnvelopeToleranceDb = 1.0;
+static const double kSilenceDb = -90.0;   // Windows quieter than this in both runs always match
+static const double kSimdToleranceDb = 0.05;
+
+static int gFailures = 0;
+
+#define CHECK(cond, ...)                                           \
+    do {                                                           \
+        if (!(cond)) {                                             \
+            std::printf("  FAIL %s:%d: ", __FILE__, __LINE__);     \
+            std::printf(__VA_ARGS__);                              \
+            std::printf("\n");                                     \
+            gFailures++;                                           \
+        }                                                          \
+    } while (0)
+
+// ============================================================================
+// Golden files
+// ============================================================================
+
+struct GoldenRun {
+    std::vector<Transition> transitions;
+    std::vector<float> envelopeDb;
+};
+
+typedef std::map<std::string, GoldenRun> GoldenFile;
+
+static std::string goldenPath(const std::string& dir, const Fixture& fixture)
+{
+    return dir + "/" + fixture.name + ".txt";
+}
+
+static bool loadGolden(const std::string& path, GoldenFile& golden)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line, current;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line[0] == '[') {
+            current = line.substr(1, line.find(']') - 1);
+            golden[current];
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string key, token;
+        fields >> key;
+        GoldenRun& run = golden[current];
+        while (fields >> token) {
+            if (key == "transitions") run.transitions.push_back({ token[0] == '+', std::atof(token.c_str() + 1) });
+            else if (key == "envelope") run.envelopeDb.push_back(static_cast<float>(std::atof(token.c_str())));
+        }
+    }
+    return true;
+}
+
+static void writeGolden(const std::string& path, const Fixture& fixture,
+                        const std::vector<Config>& configs, const std::vector<RunResult>& results)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::printf("cannot write %s\n", path.c_str());
+        gFailures++;
+        return;
+    }
+    std::fprintf(file, "# FrequencyGate golden output: %s fixture, %d channels, 48 kHz\n", fixture.name.c_str(), fixture.channels);
+    std::fprintf(file, "# transitions: gate open (+) / close (-) in ms; envelope: output RMS in dB per 20 ms\n");
+    std::fprintf(file, "# Regenerate with: frequencygate-tests tests/golden --update-golden\n");
+    for (size_t k = 0; k < configs.size(); k++) {
+        std::fprintf(file, "\n[%s]\ntransitions", configs[k].name.c_str());
+        for (const Transition& t : results[k].transitions) std::fprintf(file, " %c%.1f", t.open ? '+' : '-', t.ms);
+        std::fprintf(file, "\nenvelope");
+        for (float db : results[k].envelopeDb) std::fprintf(file, " %.1f", db);
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+}
+
+static void compareGolden(const std::string& label, const GoldenRun& golden, const RunResult& result)
+{
+    const double hopMs = result.hopSize * 1000.0 / kSampleRate;
+    const double slackMs = 2.0 * hopMs;
+
+    CHECK(golden.transitions.size() == result.transitions.size(),
+          "%s: %zu transitions, golden has %zu", label.c_str(), result.transitions.size(), golden.transitions.size());
+    const size_t count = std::min(golden.transitions.size(), result.transitions.size());
+    for (size_t i = 0; i < count; i++) {
+        const Transition& g = golden.transitions[i];
+        const Transition& r = result.transitions[i];
+        CHECK(g.open == r.open && std::fabs(g.ms - r.ms) <= slackMs,
+              "%s: transition %zu is %c%.1f ms, golden %c%.1f ms", label.c_str(), i,
+              r.open ? '+' : '-', r.ms, g.open ? '+' : '-', g.ms);
+    }
+
+    CHECK(golden.envelopeDb.size() == result.envelopeDb.size(), "%s: envelope length %zu, golden %zu",
+          label.c_str(), result.envelopeDb.size(), golden.envelopeDb.size());
+    const double windowMs = kEnvelopeWindowSeconds * 1000.0;
+    int mismatches = 0;
+    for (size_t w = 0; w < std::min(golden.envelopeDb.size(), result.envelopeDb.size()); w++) {
+        const double a = golden.envelopeDb[w];
+        const double b = result.envelopeDb[w];
+        if ((a < kSilenceDb && b < kSilenceDb) || std::fabs(a - b) <= kEnvelopeToleranceDb) continue;
+        const double start = w * windowMs, end = start + windowMs;
+        bool nearTransition = false;
+        for (const Transition& t : golden.transitions)
+            nearTransition |= t.ms + slackMs >= start && t.ms - slackMs <= end;
+        if (!nearTransition && mismatches++ < 3)
+            CHECK(false, "%s: envelope at %.0f ms is %.1f dB, golden %.1f dB", label.c_str(), start, b, a);
+    }
+}
+
+static void runGoldenTests(const std::string& dir, bool update)
+{
+    const std::vector<Config> configs = makeConfigs();
+    for (const Fixture& fixture : makeAllFixtures()) {
+        std::printf("golden: %s (%zu configurations)\n", fixture.name.c_str(), configs.size());
+        std::vector<RunResult> results;
+        for (const Config& config : configs) results.push_back(runFixture(fixture, config));
+
+        const std::string path = goldenPath(dir, fixture);
+        if (update) {
+            writeGolden(path, fixture, configs, results);
+            continue;
+        }
+        GoldenFile golden;
+        if (!loadGolden(path, golden)) {
+            CHECK(false, "missing golden file %s", path.c_str());
+            continue;
+        }
+        for (size_t k = 0; k < configs.size(); k++) {
+            const auto it = golden.find(configs[k].name);
+            if (it == golden.end()) {
+                CHECK(false, "%s: no golden entry for %s", path.c_str(), configs[k].name.c_str());
+                continue;
+            }
+            compareGolden(fixture.name + " " + configs[k].name, it->second, results[k]);
+        }
+    }
+}
+
+// ============================================================================
+// Invariants
+// ============================================================================
+
+static std::vector<float> processBlocks(const Fixture& fixture, const Config& config, const std::vector<uint32_t>& blocks)
+{
+    FrequencyGateDSP dsp(fixture.channels);
+    configure(dsp, fixture, config);
+    const uint64_t frames = fixture.frames();
+    std::vector<float> output(fixture.samples.size());
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    uint64_t pos = 0;
+    for (size_t b = 0; pos < frames; b++) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(blocks[b % blocks.size()], frames - pos));
+        for (int c = 0; c < fixture.channels; c++) {
+            in[c] = fixture.channel(c) + pos;
+            out[c] = &output[c * frames + pos];
+        }
+        dsp.process(in.data(), out.data(), count);
+        pos += count;
+    }
+    return output;
+}
+
+// The output must not depend on how the host slices the stream
+static void testBlockSizeIndependence()
+{
+    std::printf("invariant: block size independence\n");
+    const Fixture voice = makeVoice();
+    const Config configs[] = { { "default", {} }, { "spectral", { { kParamGateMode, kGateSpectral } } },
+                               { "preopen", { { kParamPreOpen, 3.0f } } } };
+    for (const Config& config : configs) {
+        const std::vector<float> whole = processBlocks(voice, config, { static_cast<uint32_t>(voice.frames()) });
+        const std::vector<float> sliced = processBlocks(voice, config, { 1, 7, 64, 333, 4096, 17, 512, 1000 });
+        CHECK(whole == sliced, "%s: output depends on the block size", config.name.c_str());
+    }
+}
+
+// With no attenuation the gate is a pure delay of exactly the reported latency
+static void testLatencyAlignment()
+{
+    std::printf("invariant: latency alignment\n");
+    const Fixture bursts = makeBursts();
+    for (float preopen : { 0.0f, 2.5f, 10.0f }) {
+        const Config config = { "unity", { { kParamRange, 0.0f }, { kParamPreOpen, preopen } } };
+        const RunResult result = runFixture(bursts, config);
+        const uint64_t frames = bursts.frames();
+        bool aligned = true;
+        for (int c = 0; c < bursts.channels; c++) {
+            const float* x = bursts.channel(c);
+            const float* y = &result.output[c * frames];
+            for (uint64_t i = 0; i < frames; i++)
+                aligned &= y[i] == (i >= result.latency ? x[i - result.latency] : 0.0f);
+        }
+        CHECK(aligned, "pre-open %.1f ms: output is not the input delayed by %u frames", preopen, result.latency);
+    }
+}
+
+// The closed-form envelope tracks the per-sample recursion it replaced. Scripted levels drive
+// attack, hold and release (including reversals mid-curve) over a DC input, so the output is
+// the gain itself; blocks straddle the power table length so curves restart mid-block.
+static void testEnvelope()
+{
+    std::printf("invariant: envelope\n");
+    const double rate = kSampleRate;
+    const uint64_t frames = static_cast<uint64_t>(rate * 2.0);
+    const std::vector<float> ones(frames, 1.0f);
+    const std::vector<uint32_t> blocks = { 1, 1023, 1025, 100, 3000, 4096, 7, 2048 };
+    // Hops open (level 0 dB) / closed (-100 dB), repeated
+    const int pattern[] = { 12, 6, 1, 20, 3, 2, 40 };
+    const float envelopes[][3] = { { 50.0f, 0.0f, 200.0f }, { 0.5f, 30.0f, 20.0f }, { 10.0f, 100.0f, 500.0f } };
+
+    for (const auto& times : envelopes) {
+        FrequencyGateDSP dsp(1);
+        dsp.setSampleRate(rate);
+        dsp.setParameter(kParamThreshold, -40.0f);
+        dsp.setParameter(kParamPreOpen, 0.0f);
+        dsp.setParameter(kParamRange, -60.0f);
+        dsp.setParameter(kParamAttack, times[0]);
+        dsp.setParameter(kParamHold, times[1]);
+        dsp.setParameter(kParamRelease, times[2]);
+        dsp.activate();
+        const int hop = dsp.getHopSize();
+
+        std::vector<float> levels(frames / hop + 1);
+        for (size_t k = 0, run = 0, left = pattern[0]; k < levels.size(); k++, left--) {
+            while (left == 0) left = pattern[++run % (sizeof(pattern) / sizeof(pattern[0]))];
+            levels[k] = run % 2 == 0 ? 0.0f : -100.0f;
+        }
+
+        std::vector<float> output(frames);
+        const float* in[3] = { nullptr, nullptr, nullptr };
+        float* out[1];
+        size_t used = 0;
+        uint64_t pos = 0;
+        for (size_t b = 0; pos < frames; b++) {
+            const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(blocks[b % blocks.size()], frames - pos));
+            in[0] = ones.data() + pos;
+            out[0] = output.data() + pos;
+            used += dsp.processWithLevels(in, out, count, levels.data() + used);
+            pos += count;
+        }
+
+        // Reference: the gate logic per hop, then one recursion step per sample
+        const float attack = std::exp(-1.0f / (static_cast<float>(rate) * times[0] / 1000.0f));
+        const float release = std::exp(-1.0f / (static_cast<float>(rate) * times[2] / 1000.0f));
+        const int holdSamples = static_cast<int>(times[1] * rate / 1000.0f);
+        const double rangeGain = std::pow(10.0, -60.0 / 20.0);
+        bool open = false;
+        int hold = 0;
+        size_t hopIndex = 0;
+        double env = 0.0, worst = 0.0;
+        for (uint64_t i = 0; i < frames; i++) {
+            if ((i + 1) % hop == 0) {
+                if (levels[hopIndex++] >= -40.0f) {
+                    open = true;
+                    hold = holdSamples;
+                } else if (hold > 0) {
+                    hold -= hop;
+                } else {
+                    open = false;
+                }
+            }
+            const double target = open ? 1.0 : 0.0;
+            if (target > env) env = target - (target - env) * attack;
+            else if (hold <= 0) env = target - (target - env) * release;
+            worst = std::max(worst, std::fabs(output[i] - (rangeGain + (1.0 - rangeGain) * env)));
+        }
+        CHECK(used == hopIndex, "attack %.1f ms: %zu levels used, reference made %zu hops", times[0], used, hopIndex);
+        CHECK(worst <= 1e-5, "attack %.1f / hold %.0f / release %.0f ms: gain differs from the recursion by %g",
+              times[0], times[1], times[2], worst);
+    }
+}
+
+// The offline two-pass path (analyze + processWithLevels) must match process()
+static void testSplitAnalysis()
+{
+    std::printf("invariant: split analysis\n");
+    const Fixture voice = makeVoice();
+    const Config config = { "split", { { kParamDetectionMethod, kDetectTrimmedMean }, { kParamAutoThreshold, 1.0f } } };
+    const std::vector<float> reference = processBlocks(voice, config, { 256 });
+
+    const uint64_t frames = voice.frames();
+    std::vector<const float*> in(voice.channels + 2, nullptr);
+    for (int c = 0; c < voice.channels; c++) in[c] = voice.channel(c);
+
+    FrequencyGateDSP analyzer(voice.channels);
+    configure(analyzer, voice, config);
+    CHECK(analyzer.canSplitAnalysis(), "broadband analysis should be splittable");
+    std::vector<float> levels(frames / analyzer.getHopSize() + 1);
+    const uint32_t hops = analyzer.analyze(in.data(), static_cast<uint32_t>(frames), levels.data());
+
+    FrequencyGateDSP applier(voice.channels);
+    configure(applier, voice, config);
+    std::vector<float> output(voice.samples.size());
+    std::vector<float*> out(voice.channels);
+    for (int c = 0; c < voice.channels; c++) out[c] = &output[c * frames];
+    const uint32_t used = applier.processWithLevels(in.data(), out.data(), static_cast<uint32_t>(frames), levels.data());
+    CHECK(used == hops, "apply pass used %u levels, analysis produced %u", used, hops);
+    CHECK(output == reference, "split analysis output differs from process()");
+
+    // Averaged levels depend on every earlier hop, so chunked analysis is off
+    applier.setParameter(kParamAveraging, 40.0f);
+    CHECK(!applier.canSplitAnalysis(), "averaged analysis should not be splittable");
+}
+
+// Hop phases (instance staggering) move the hop boundaries only: the latency is unchanged,
+// spectral output is still the input delayed by one frame, and decisions shift by under a hop
+static RunResult runPhased(const Fixture& fixture, const Config& config, float phase, uint32_t block)
+{
+    RunResult result;
+    FrequencyGateDSP dsp(fixture.channels);
+    dsp.setHopPhase(phase);
+    configure(dsp, fixture, config);
+    result.latency = dsp.getLatency();
+    result.hopSize = dsp.getHopSize();
+
+    const uint64_t frames = fixture.frames();
+    result.output.assign(fixture.samples.size(), 0.0f);
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    bool open = dsp.isGateOpen();
+    for (uint64_t pos = 0; pos < frames; ) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, frames - pos));
+        for (int c = 0; c < fixture.channels; c++) {
+            in[c] = fixture.channel(c) + pos;
+            out[c] = &result.output[c * frames + pos];
+        }
+        dsp.process(in.data(), out.data(), count);
+        pos += count;
+        if (dsp.isGateOpen() != open) {
+            open = dsp.isGateOpen();
+            result.transitions.push_back({ open, pos * 1000.0 / fixture.sampleRate });
+        }
+    }
+    return result;
+}
+
+static void testHopPhase()
+{
+    std::printf("invariant: hop phase\n");
+    // Any 8 consecutive instances take 8 different eighths of the hop
+    bool even = true;
+    for (uint32_t first : { 0u, 5u, 1000u }) {
+        int slots = 0;
+        for (uint32_t i = first; i < first + 8; i++) slots |= 1 << static_cast<int>(HopPhase::fromIndex(i) * 8.0f);
+        even &= slots == 0xFF;
+    }
+    CHECK(even && HopPhase::fromIndex(0) == 0.0f, "hop phases are not evenly spread");
+
+    const Fixture bursts = makeBursts();
+    const uint32_t block = 64;
+    const RunResult reference = runFixture(bursts, { "default", {} });
+    for (float phase : { 0.25f, 0.5f, 0.875f }) {
+        const RunResult result = runPhased(bursts, { "default", {} }, phase, block);
+        const double toleranceMs = (result.hopSize + block) * 1000.0 / bursts.sampleRate;
+        bool close = result.transitions.size() == reference.transitions.size();
+        for (size_t t = 0; close && t < result.transitions.size(); t++)
+            close = result.transitions[t].open == reference.transitions[t].open
+                 && std::fabs(result.transitions[t].ms - reference.transitions[t].ms) <= toleranceMs;
+        CHECK(close, "phase %.3f: transitions move by more than a hop", phase);
+        CHECK(result.latency == reference.latency, "phase %.3f: latency %u, expected %u", phase, result.latency,
+              reference.latency);
+
+        // Spectral with no attenuation resynthesizes the input one frame late (after the first frame)
+        const Config unity = { "spectral", { { kParamGateMode, kGateSpectral }, { kParamRange, 0.0f } } };
+        const RunResult spectral = runPhased(bursts, unity, phase, block);
+        const uint64_t frames = bursts.frames();
+        double worst = 0.0;
+        for (int c = 0; c < bursts.channels; c++)
+            for (uint64_t i = 2 * spectral.latency; i < frames; i++)
+                worst = std::max(worst, std::fabs(static_cast<double>(spectral.output[c * frames + i])
+                                                  - bursts.channel(c)[i - spectral.latency]));
+        CHECK(worst < 1e-4, "phase %.3f: spectral output is not the input delayed by %u frames (error %g)", phase,
+              spectral.latency, worst);
+    }
+}
+
+// Multichannel: one gain curve for every channel, so scaled copies stay scaled copies
+static void testLinkedChannels()
+{
+    std::printf("invariant: linked channels\n");
+    const Fixture tones = makeTones(1);
+    const int channels = 6;
+    Fixture multi;
+    multi.name = "tones6";
+    multi.channels = channels;
+    multi.sampleRate = tones.sampleRate;
+    multi.threshold = tones.threshold;
+    multi.samples.resize(tones.samples.size() * channels);
+    for (int c = 0; c < channels; c++)
+        for (uint64_t i = 0; i < tones.frames(); i++) multi.channel(c)[i] = tones.samples[i] * (c + 1) * 0.125f;
+
+    const RunResult result = runFixture(multi, { "linked", { { kParamHold, 20.0f } } });
+    const uint64_t frames = multi.frames();
+    double worst = 0.0;
+    for (int c = 1; c < channels; c++) {
+        for (uint64_t i = 0; i < frames; i++) {
+            const double expected = result.output[i] * (c + 1);
+            worst = std::max(worst, std::fabs(result.output[c * frames + i] - expected));
+        }
+    }
+    CHECK(worst < 1e-6, "channel gains differ (max deviation %g)", worst);
+}
+
+// Detection levels of every hop from the offline analysis pass; `sidechain` feeds the key inputs
+static std::vector<float> analyzeLevels(const Fixture& fixture, const Config& config, const Fixture* sidechain = nullptr)
+{
+    FrequencyGateDSP dsp(fixture.channels);
+    configure(dsp, fixture, config);
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    for (int c = 0; c < fixture.channels; c++) in[c] = fixture.channel(c);
+    if (sidechain)
+        for (int c = 0; c < 2; c++) in[fixture.channels + c] = sidechain->channel(c);
+    std::vector<float> levels(fixture.frames() / dsp.getHopSize() + 1);
+    levels.resize(dsp.analyze(in.data(), static_cast<uint32_t>(fixture.frames()), levels.data()));
+    return levels;
+}
+
+// Averaging steadies the band level: on stationary noise the hop-to-hop change of the detected
+// level must at least halve with it on, at the short FFT it is meant for
+static void testAveraging()
+{
+    std::printf("invariant: averaging\n");
+    Fixture noise;
+    noise.name = "noise";
+    noise.channels = 1;
+    noise.sampleRate = kSampleRate;
+    noise.threshold = -40.0f;
+    noise.samples.resize(static_cast<size_t>(3.0 * kSampleRate));
+    Noise source(31);
+    for (float& sample : noise.samples) sample = 0.03f * source.next();
+
+    // RMS of the hop-to-hop level change, after the first half second of warm-up
+    auto deviation = [&](float averagingMs) {
+        const Config config = { "averaging", { { kParamFFTSize, kFFTSize512 }, { kParamAveraging, averagingMs } } };
+        const std::vector<float> levels = analyzeLevels(noise, config);
+        const size_t first = levels.size() / 6;
+        double sum = 0.0;
+        for (size_t k = first + 1; k < levels.size(); k++) sum += (levels[k] - levels[k - 1]) * (levels[k] - levels[k - 1]);
+        return std::sqrt(sum / (levels.size() - first - 1));
+    };
+    const double off = deviation(0.0f);
+    const double on = deviation(40.0f);
+    CHECK(on <= 0.5 * off, "averaging 40 ms: hop-to-hop level change %.3f dB, %.3f dB without", on, off);
+}
+
+// Per-channel detection: out-of-phase channels cancel in the mix but not per channel, and the
+// paired complex transform measures each channel as its own real transform would
+static void testChannelDetect()
+{
+    std::printf("invariant: channel detect\n");
+    const Fixture mono[] = { makeTones(1), makeBursts(1), makeVoice(1) };
+    const uint64_t frames = mono[0].frames();
+
+    Fixture opposed = mono[0];
+    opposed.name = "tones_opposed";
+    opposed.channels = 2;
+    opposed.samples.resize(2 * frames);
+    for (uint64_t i = 0; i < frames; i++) opposed.channel(1)[i] = -mono[0].samples[i];
+
+    const RunResult reference = runFixture(mono[0], { "mono", {} });
+    const double hopMs = 1000.0 * reference.hopSize / mono[0].sampleRate;
+    CHECK(runFixture(opposed, { "mix", {} }).transitions.empty(), "opposed channels should cancel in the mix");
+    for (int mode = kChannelMax; mode < kChannelDetectCount; mode++) {
+        const RunResult result = runFixture(opposed, { "per_channel", { { kParamChannelDetect, static_cast<float>(mode) } } });
+        bool match = result.transitions.size() == reference.transitions.size();
+        for (size_t k = 0; match && k < result.transitions.size(); k++)
+            match = result.transitions[k].open == reference.transitions[k].open &&
+                    std::fabs(result.transitions[k].ms - reference.transitions[k].ms) <= hopMs;
+        CHECK(match, "mode %d: opposed channels should gate like one (%zu transitions, expected %zu)",
+              mode, result.transitions.size(), reference.transitions.size());
+    }
+
+    Fixture trio = mono[0];
+    trio.name = "trio";
+    trio.channels = 3;
+    trio.samples.resize(3 * frames);
+    for (int c = 0; c < 3; c++) std::copy(mono[c].samples.begin(), mono[c].samples.end(), trio.channel(c));
+
+    // Per-bin combinations that reduce to a combination of the per-channel levels
+    struct Identity { int mode; int method; double power; };   // power: 0 = max, else mean of 10^(dB/power)
+    static const Identity identities[] = {
+        { kChannelMax, kDetectPeak, 0.0 }, { kChannelMean, kDetectAverage, 20.0 }, { kChannelLinked, kDetectRMS, 10.0 },
+    };
+    for (int gateMode = kGateBroadband; gateMode < kGateModeCount; gateMode++) {
+        for (const Identity& id : identities) {
+            const Config single = { "single", { { kParamGateMode, static_cast<float>(gateMode) },
+                                                { kParamDetectionMethod, static_cast<float>(id.method) } } };
+            Config combined = single;
+            combined.params.push_back({ kParamChannelDetect, static_cast<float>(id.mode) });
+            std::vector<std::vector<float>> channelLevels;
+            for (const Fixture& fixture : mono) channelLevels.push_back(analyzeLevels(fixture, single));
+            const std::vector<float> levels = analyzeLevels(trio, combined);
+
+            double worst = 0.0;
+            for (size_t h = 0; h < levels.size(); h++) {
+                double expected = id.power > 0.0 ? 0.0 : -96.0;
+                bool audible = levels[h] > kSilenceDb;
+                for (const std::vector<float>& channel : channelLevels) {
+                    audible &= channel[h] > kSilenceDb;
+                    if (id.power > 0.0) expected += std::pow(10.0, channel[h] / id.power) / 3.0;
+                    else expected = std::max(expected, static_cast<double>(channel[h]));
+                }
+                if (id.power > 0.0) expected = id.power * std::log10(expected);
+                if (audible) worst = std::max(worst, std::fabs(levels[h] - expected));
+            }
+            CHECK(worst < 0.01, "%s mode %d: levels differ from the separate channels by %.4f dB",
+                  gateMode == kGateSpectral ? "spectral" : "broadband", id.mode, worst);
+        }
+    }
+
+    // A sidechain pair is analyzed per channel as well
+    Fixture silent = mono[0];
+    std::fill(silent.samples.begin(), silent.samples.end(), 0.0f);
+    const Config peak = { "peak", { { kParamKeySource, kKeySidechain }, { kParamDetectionMethod, kDetectPeak } } };
+    Config peakMax = peak;
+    peakMax.params.push_back({ kParamChannelDetect, kChannelMax });
+    const std::vector<float> mixed = analyzeLevels(silent, peak, &opposed);
+    const std::vector<float> perChannel = analyzeLevels(silent, peakMax, &opposed);
+    const std::vector<float> single = analyzeLevels(mono[0], { "peak", { { kParamDetectionMethod, kDetectPeak } } });
+    double worst = 0.0, loudestMix = -96.0;
+    for (size_t h = 0; h < perChannel.size(); h++) {
+        worst = std::max(worst, static_cast<double>(std::fabs(perChannel[h] - single[h])));
+        loudestMix = std::max(loudestMix, static_cast<double>(mixed[h]));
+    }
+    CHECK(loudestMix <= -96.0, "opposed sidechain should cancel in the mix (%.1f dB)", loudestMix);
+    CHECK(worst < 0.01, "sidechain per-channel levels differ from the channel by %.4f dB", worst);
+}
+
+// Every size option keeps its window (and so its timing) at other sample rates
+static void testSampleRateNormalization()
+{
+    std::printf("invariant: sample rate normalization\n");
+    const double rates[] = { 44100.0, 88200.0, 96000.0, 192000.0 };
+    for (int option = 0; option < kFFTSizeCount; option++) {
+        const Config config = { "spectral", { { kParamFFTSize, static_cast<float>(option) }, { kParamGateMode, kGateSpectral } } };
+        const RunResult reference = runFixture(makeTones(1), config);
+        for (double rate : rates) {
+            const RunResult result = runFixture(makeTones(1, 3.0, rate), config);
+            const double windowMs = result.latency * 1000.0 / rate;
+            CHECK(isFFTSizeSupported(static_cast<int>(result.latency)) && std::fabs(windowMs / getFFTWindowMs(option) - 1.0) < 0.05,
+                  "option %d at %.0f Hz: %u-point window is %.2f ms", option, rate, result.latency, windowMs);
+
+            const double slackMs = 2.0 * reference.hopSize * 1000.0 / kSampleRate;
+            bool same = result.transitions.size() == reference.transitions.size();
+            for (size_t i = 0; same && i < result.transitions.size(); i++)
+                same = result.transitions[i].open == reference.transitions[i].open
+                    && std::fabs(result.transitions[i].ms - reference.transitions[i].ms) <= slackMs;
+            CHECK(same, "option %d at %.0f Hz: gate timing differs from 48 kHz", option, rate);
+        }
+    }
+}
+
+// Engines with their own config each, processed one after another every block as a host would
+static std::vector<std::vector<float>> processTogether(const Fixture& fixture, const std::vector<Config>& configs,
+                                                       const std::vector<uint32_t>& blocks)
+{
+    std::vector<std::unique_ptr<FrequencyGateDSP>> engines;
+    for (const Config& config : configs) {
+        engines.emplace_back(new FrequencyGateDSP(fixture.channels));
+        configure(*engines.back(), fixture, config);
+    }
+    const uint64_t frames = fixture.frames();
+    std::vector<std::vector<float>> outputs(configs.size(), std::vector<float>(fixture.samples.size()));
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    uint64_t pos = 0;
+    for (size_t b = 0; pos < frames; b++) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(blocks[b % blocks.size()], frames - pos));
+        for (size_t e = 0; e < engines.size(); e++) {
+            for (int c = 0; c < fixture.channels; c++) {
+                in[c] = fixture.channel(c) + pos;
+                out[c] = &outputs[e][c * frames + pos];
+            }
+            engines[e]->process(in.data(), out.data(), count);
+        }
+        pos += count;
+    }
+    return outputs;
+}
+
+// Share groups: a follower processed after its leader makes the same decisions at the same
+// hops, a stalled leader is replaced within SHARE_STALE_MS (at block granularity), leaving a
+// group frees the leader slot, and Spectral mode always analyzes its own signal
+static void testShareGroups()
+{
+    std::printf("invariant: share groups\n");
+    const Fixture voice = makeVoice();
+    const std::vector<uint32_t> blocks = { 1, 7, 64, 333, 4096, 17, 512, 1000 };
+    const Config config = { "default", { { kParamHold, 20.0f } } };
+    const Config shared = { "shared", { { kParamHold, 20.0f }, { kParamShareGroup, 1.0f } } };
+    const std::vector<float> alone = processBlocks(voice, config, blocks);
+    const std::vector<std::vector<float>> pair = processTogether(voice, { shared, shared }, blocks);
+    CHECK(pair[0] == alone, "leader output differs from a standalone engine");
+    CHECK(pair[1] == alone, "follower output differs from a standalone engine");
+
+    const Config spectral = { "spectral", { { kParamGateMode, kGateSpectral } } };
+    const Config spectralShared = { "spectral", { { kParamGateMode, kGateSpectral }, { kParamShareGroup, 2.0f } } };
+    const std::vector<std::vector<float>> mixed = processTogether(voice, { { "leader", { { kParamShareGroup, 2.0f } } }, spectralShared }, blocks);
+    CHECK(mixed[1] == processBlocks(voice, spectral, blocks), "spectral engine followed the group leader");
+
+    // Takeover: the leader stops processing, the follower keeps going
+    const int group = 3;
+    const uint32_t block = 256;
+    const Config takeover = { "takeover", { { kParamShareGroup, static_cast<float>(group) } } };
+    FrequencyGateDSP leader(voice.channels), follower(voice.channels);
+    configure(leader, voice, takeover);
+    configure(follower, voice, takeover);
+    std::vector<float> scratch(voice.channels * block);
+    std::vector<const float*> in(voice.channels + 2, nullptr);
+    std::vector<float*> out(voice.channels);
+    for (int c = 0; c < voice.channels; c++) out[c] = &scratch[c * block];
+    uint64_t pos = 0;
+    auto run = [&](FrequencyGateDSP& dsp) {
+        for (int c = 0; c < voice.channels; c++) in[c] = voice.channel(c) + pos;
+        dsp.process(in.data(), out.data(), block);
+    };
+    for (; pos < voice.frames() / 4; pos += block) {
+        run(leader);
+        run(follower);
+    }
+    CHECK(SharedAnalysisBus::leader(group) == &leader, "first engine did not lead its group");
+    const uint64_t stopped = pos;
+    while (SharedAnalysisBus::leader(group) != &follower && pos + block <= voice.frames()) {
+        run(follower);
+        pos += block;
+    }
+    const uint64_t limit = static_cast<uint64_t>(voice.sampleRate * SHARE_STALE_MS / 1000.0) + 2 * block;
+    CHECK(SharedAnalysisBus::leader(group) == &follower && pos - stopped <= limit,
+          "follower took over after %.1f ms", (pos - stopped) * 1000.0 / voice.sampleRate);
+
+    // Leaving the group: deactivate() and the destructor release the slot
+    pos = 0;
+    follower.deactivate();
+    CHECK(SharedAnalysisBus::leader(group) == nullptr, "deactivated leader kept its slot");
+    {
+        FrequencyGateDSP owner(voice.channels);
+        configure(owner, voice, takeover);
+        run(owner);
+        CHECK(SharedAnalysisBus::leader(group) == &owner, "free group was not claimed");
+    }
+    CHECK(SharedAnalysisBus::leader(group) == nullptr, "destroyed leader kept its slot");
+    run(leader);
+    CHECK(SharedAnalysisBus::leader(group) == &leader, "free group was not claimed after its leader was destroyed");
+}
+
+// Engine counters agree with what the run actually did
+static void testInstrumentation()
+{
+    std::printf("invariant: instrumentation counters\n");
+    if (!GateStats::enabled()) return;
+    const Fixture tones = makeTones();
+    const Config config = { "counters", { { kParamHold, 20.0f } } };
+    const RunResult reference = runFixture(tones, config);
+
+    FrequencyGateDSP dsp(tones.channels);
+    configure(dsp, tones, config);
+    const uint64_t frames = tones.frames();
+    const uint32_t block = 256;
+    std::vector<float> output(tones.samples.size());
+    std::vector<const float*> in(tones.channels + 2, nullptr);
+    std::vector<float*> out(tones.channels);
+    for (uint64_t pos = 0; pos < frames; pos += block) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, frames - pos));
+        for (int c = 0; c < tones.channels; c++) {
+            in[c] = tones.channel(c) + pos;
+            out[c] = &output[c * frames + pos];
+        }
+        dsp.process(in.data(), out.data(), count);
+    }
+
+    const GateStats::Snapshot s = dsp.getStats().snapshot();
+    uint64_t histogram = 0;
+    for (uint64_t count : s.histogram) histogram += count;
+    CHECK(s.blocks == (frames + block - 1) / block, "%llu blocks counted", static_cast<unsigned long long>(s.blocks));
+    CHECK(s.frames == frames, "%llu frames counted", static_cast<unsigned long long>(s.frames));
+    CHECK(histogram == s.blocks, "histogram holds %llu blocks", static_cast<unsigned long long>(histogram));
+    CHECK(s.hops == frames / dsp.getHopSize() && s.analyses == s.hops, "%llu hops, %llu analyses counted",
+          static_cast<unsigned long long>(s.hops), static_cast<unsigned long long>(s.analyses));
+    CHECK(s.transitions == reference.transitions.size(), "%llu transitions counted, %zu observed",
+          static_cast<unsigned long long>(s.transitions), reference.transitions.size());
+    CHECK(s.reinits == 1, "%llu reinits counted", static_cast<unsigned long long>(s.reinits));
+    CHECK(s.blockNsMax >= s.blockNs / s.blocks, "worst block below the average");
+
+    dsp.getStats().requestReset();
+    dsp.process(in.data(), out.data(), 0);
+    CHECK(dsp.getStats().snapshot().blocks == 1, "reset did not clear the counters");
+}
+
+// Drive the fixture in 256-frame blocks with an event ring attached; returns the events pushed
+static std::vector<GateEvent> runWithEvents(const Fixture& fixture, const Config& config, GateEventRing& ring,
+                                            bool drain)
+{
+    FrequencyGateDSP dsp(fixture.channels);
+    dsp.setEventRing(&ring);
+    configure(dsp, fixture, config);
+    const uint64_t frames = fixture.frames();
+    const uint32_t block = 256;
+    std::vector<float> output(fixture.samples.size());
+    std::vector<const float*> in(fixture.channels + 2, nullptr);
+    std::vector<float*> out(fixture.channels);
+    std::vector<GateEvent> events;
+    GateEvent event;
+    for (uint64_t pos = 0; pos < frames; pos += block) {
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(block, frames - pos));
+        for (int c = 0; c < fixture.channels; c++) {
+            in[c] = fixture.channel(c) + pos;
+            out[c] = &output[c * frames + pos];
+        }
+        dsp.process(in.data(), out.data(), count);
+        while (drain && ring.pop(event)) events.push_back(event);
+    }
+    dsp.setParameter(kParamThreshold, fixture.threshold + 6.0f);
+    dsp.process(in.data(), out.data(), 0);
+    while (drain && ring.pop(event)) events.push_back(event);
+    return events;
+}
+
+static void testEventLog()
+{
+    std::printf("invariant: event log\n");
+    const Fixture tones = makeTones();
+    const Config config = { "events", { { kParamHold, 20.0f } } };
+    const RunResult reference = runFixture(tones, config);
+
+    GateEventRing ring(1 << 16);
+    const std::vector<GateEvent> events = runWithEvents(tones, config, ring, true);
+    CHECK(!events.empty() && events[0].type == kEventStart && events[0].value == tones.sampleRate, "no start event");
+
+    // Every transition, at the sample the hop ended on; every non-output parameter once at
+    // activation, then the threshold change at the last block
+    std::vector<Transition> transitions;
+    size_t holdExpiries = 0, closes = 0, parameters = 0;
+    for (const GateEvent& e : events) {
+        if (e.type == kEventOpen || e.type == kEventClose)
+            transitions.push_back({ e.type == kEventOpen, e.sample * 1000.0 / tones.sampleRate });
+        closes += e.type == kEventClose ? 1 : 0;
+        holdExpiries += e.type == kEventHoldExpired ? 1 : 0;
+        parameters += e.type == kEventParameter ? 1 : 0;
+    }
+    bool match = transitions.size() == reference.transitions.size();
+    for (size_t i = 0; match && i < transitions.size(); i++)
+        match = transitions[i].open == reference.transitions[i].open && transitions[i].ms == reference.transitions[i].ms;
+    CHECK(match, "%zu transitions logged, %zu observed", transitions.size(), reference.transitions.size());
+    CHECK(holdExpiries >= closes, "%zu hold expiries for %zu closes", holdExpiries, closes);
+    const size_t logged = kParamChannelWeight0 - 3 + tones.channels;   // Minus noise floor and DSP meters
+    CHECK(parameters == logged + 1, "%zu parameter events, expected %zu", parameters, logged + 1);
+    const GateEvent& last = events.back();
+    CHECK(last.type == kEventParameter && last.param == kParamThreshold && last.sample == tones.frames(),
+          "threshold change not logged at the end");
+
+    // Nobody draining: a small ring fills up, then drops and counts instead of blocking
+    GateEventRing small(4);
+    runWithEvents(tones, config, small, false);
+    CHECK(small.dropped() == events.size() - small.capacity(), "%llu events dropped, expected %zu",
+          static_cast<unsigned long long>(small.dropped()), events.size() - small.capacity());
+}
+
+// A captured session replays to the same output and decisions: odd block sizes, in-place
+// buffers, a parameter change that rebuilds the analysis, and a reactivation at another rate
+static void testCapture()
+{
+    std::printf("invariant: capture replay\n");
+    SpscRing<uint32_t> ring(8);
+    const uint32_t items[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    uint32_t popped[10] = {};
+    bool bulk = ring.pushAll(items, 5) && ring.popSome(popped, 3) == 3 && ring.pushAll(items + 5, 5)
+             && !ring.pushAll(items, 2) && ring.popSome(popped + 3, 10) == 7;
+    for (int i = 0; bulk && i < 10; i++) bulk = popped[i] == items[i];
+    CHECK(bulk && ring.dropped() == 1, "bulk ring operations out of order");
+
+    const Fixture voice = makeVoice();
+    const std::string path = (std::filesystem::temp_directory_path() / "frequencygate-test.fgcap").string();
+    const uint64_t frames = voice.frames();
+    const uint32_t blocks[] = { 64, 300, 17, 512 };
+    GateCaptureRecorder recorder;
+    CHECK(recorder.open(path, voice.channels, voice.channels + 2, "test", false), "cannot write %s", path.c_str());
+    {
+        FrequencyGateDSP dsp(voice.channels);
+        dsp.setHopPhase(HopPhase::fromIndex(3));
+        std::vector<float> buffer(voice.channels * 512);
+        std::vector<const float*> in(voice.channels + 2, nullptr);
+        std::vector<float*> out(voice.channels);
+        for (double rate : { voice.sampleRate, 44100.0 }) {
+            dsp.setSampleRate(rate);
+            dsp.setParameter(kParamThreshold, voice.threshold);
+            dsp.activate();
+            recorder.start(rate, dsp.getHopPhase());
+            size_t b = 0;
+            for (uint64_t pos = 0; pos < frames; b++) {
+                const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(blocks[b % 4], frames - pos));
+                for (int c = 0; c < voice.channels; c++) {
+                    out[c] = &buffer[c * 512];
+                    std::memcpy(out[c], voice.channel(c) + pos, count * sizeof(float));
+                    in[c] = out[c];
+                }
+                if (pos < frames / 2 && pos + count >= frames / 2) dsp.setParameter(kParamFFTSize, kFFTSize1024);
+                recorder.captureInput(dsp, in.data(), count);
+                dsp.process(in.data(), out.data(), count);
+                recorder.captureOutput(dsp, out.data(), count);
+                recorder.drain();
+                pos += count;
+            }
+            dsp.deactivate();
+        }
+    }
+    recorder.close();
+
+    GateCaptureReader reader;
+    CHECK(reader.open(path) && reader.channels() == voice.channels, "cannot read the capture back");
+    const ReplayResult result = replayCapture(reader, FrequencyGateSimd::kAuto, 0.0);
+    CHECK(result.activations == 2 && result.frames == 2 * frames && result.minBlock == 17 && result.maxBlock == 512,
+          "%llu activations, %llu frames in %u..%u-frame blocks", static_cast<unsigned long long>(result.activations),
+          static_cast<unsigned long long>(result.frames), result.minBlock, result.maxBlock);
+    CHECK(result.comparedBlocks == result.blocks && result.lostFrames == 0, "%llu of %llu blocks compared",
+          static_cast<unsigned long long>(result.comparedBlocks), static_cast<unsigned long long>(result.blocks));
+    CHECK(result.outputDiffBlocks == 0 && result.decisionDiffs == 0,
+          "replay differs: output in %llu blocks (max %g), decisions in %llu",
+          static_cast<unsigned long long>(result.outputDiffBlocks), result.maxOutputDiff,
+          static_cast<unsigned long long>(result.decisionDiffs));
+    std::filesystem::remove(path);
+}
+
+// Every instruction set variant built in and supported here must gate like the baseline build;
+// only rounding differs (FMA contraction, summation order), so levels near the threshold may
+// flip a decision by a hop
+static void testSimdLevels()
+{
+    std::printf("invariant: instruction set variants\n");
+    const Fixture voice = makeVoice();
+    const Config configs[] = {
+        { "default", {} },
+        { "spectral", { { kParamGateMode, kGateSpectral } } },
+        { "channel_max", { { kParamChannelDetect, kChannelMax } } },
+    };
+    for (const Config& config : configs) {
+        const RunResult baseline = runFixture(voice, config, FrequencyGateSimd::kBaseline);
+        for (int k = FrequencyGateSimd::kBaseline + 1; k < FrequencyGateSimd::kLevelCount; k++) {
+            const FrequencyGateSimd::Level level = static_cast<FrequencyGateSimd::Level>(k);
+            if (!FrequencyGateSimd::supported(level)) continue;
+            const RunResult result = runFixture(voice, config, level);
+            const double hopMs = result.hopSize * 1000.0 / voice.sampleRate;
+            bool close = result.transitions.size() == baseline.transitions.size();
+            for (size_t t = 0; close && t < result.transitions.size(); t++)
+                close = result.transitions[t].open == baseline.transitions[t].open
+                     && std::fabs(result.transitions[t].ms - baseline.transitions[t].ms) <= hopMs;
+            CHECK(close, "%s %s: transitions differ from %s by more than a hop", config.name.c_str(),
+                  FrequencyGateSimd::levelName(level), FrequencyGateSimd::levelName(FrequencyGateSimd::kBaseline));
+            const double windowMs = kEnvelopeWindowSeconds * 1000.0;
+            double worst = 0.0;
+            for (size_t w = 0; w < std::min(result.envelopeDb.size(), baseline.envelopeDb.size()); w++) {
+                const double a = baseline.envelopeDb[w], b = result.envelopeDb[w];
+                bool nearTransition = false;
+                for (const Transition& t : baseline.transitions)
+                    nearTransition |= t.ms + hopMs >= w * windowMs && t.ms - hopMs <= (w + 1) * windowMs;
+                if (!nearTransition && (a > kSilenceDb || b > kSilenceDb)) worst = std::max(worst, std::fabs(a - b));
+            }
+            CHECK(worst <= kSimdToleranceDb, "%s %s: envelope differs from %s by %.3f dB", config.name.c_str(),
+                  FrequencyGateSimd::levelName(level), FrequencyGateSimd::levelName(FrequencyGateSimd::kBaseline), worst);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string goldenDir = "golden";
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--update-golden") == 0) update = true;
+        else goldenDir = argv[i];
+    }
+
+    runGoldenTests(goldenDir, update);
+    if (!update) {
+        testBlockSizeIndependence();
+        testLatencyAlignment();
+        testEnvelope();
+        testSplitAnalysis();
+        testHopPhase();
+        testLinkedChannels();
+        testAveraging();
+        testChannelDetect();
+        testSampleRateNormalization();
+        testShareGroups();
+        testInstrumentation();
+        testEventLog();
+        testCapture();
+        testSimdLevels();
+    }
+
+    if (gFailures) std::printf("%d check(s) failed\n", gFailures);
+    else std::printf("all checks passed\n");
+    return gFailures ? 1 : 0;
+}